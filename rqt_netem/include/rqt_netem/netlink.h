@@ -0,0 +1,91 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_netem__netlink_H
+#define rqt_netem__netlink_H
+
+#include <QString>
+#include <QtGlobal>
+
+namespace rqt_netem {
+
+// netem parameters in the units of the tc command line
+struct NetemParameters {
+    quint32 limit = 1000;               // packets
+    double delay = 0.0;                 // ms
+    double jitter = 0.0;                // ms
+    double delay_correlation = 0.0;     // %
+    QString delay_distribution;         // name of a tc distribution table, empty for none
+    double loss = 0.0;                  // %
+    double loss_correlation = 0.0;
+    double duplicate = 0.0;
+    double duplicate_correlation = 0.0;
+    double corrupt = 0.0;
+    double corrupt_correlation = 0.0;
+    double reorder = 0.0;
+    double reorder_correlation = 0.0;
+    quint32 gap = 0;                    // packets
+    double rate = 0.0;                  // bytes/s
+    int packet_overhead = 0;            // bytes
+    quint32 cell_size = 0;
+    int cell_overhead = 0;
+    double slot_min_delay = 0.0;        // ms
+    double slot_max_delay = 0.0;
+    QString slot_distribution;          // min and max delay become the delay and the jitter
+
+    bool operator==(const NetemParameters& other) const;
+    bool operator!=(const NetemParameters& other) const { return !(*this == other); }
+};
+
+// programs links, qdiscs and filters over rtnetlink: the requests are queued and go out
+// with one sendmsg on commit(), the kernel acknowledges each of them
+class Netlink
+{
+public:
+    Netlink();
+    ~Netlink();
+
+    // 0 or the negative errno
+    int open();
+    void close();
+    bool isOpen() const;
+
+    void addLink(const QString& name, const QString& kind);
+    void deleteLink(const int& ifindex);
+    void setLinkUp(const int& ifindex, const bool& up);
+
+    void addIngressQdisc(const int& ifindex);
+    void addPrioQdisc(const int& ifindex, const quint32& handle, const int& bands);
+    void addNetemQdisc(const int& ifindex, const quint32& parent, const quint32& handle,
+        const NetemParameters& parameters);
+    // updates the qdisc in place, the queued packets stay where they are; a distribution table
+    // that is the same as in the previous parameters is not sent again, the kernel keeps it
+    void changeNetemQdisc(const int& ifindex, const quint32& parent, const quint32& handle,
+        const NetemParameters& parameters, const NetemParameters& previous);
+    // removing what is not there is no failure, so these are safe to send on a clean link
+    void deleteRootQdisc(const int& ifindex);
+    void deleteIngressQdisc(const int& ifindex);
+
+    // u32 match-all on the ingress qdisc with a mirred egress redirect to the target link
+    void addRedirectFilter(const int& ifindex, const int& target);
+    // u32 match on the IPv4 source and destination prefixes ("a.b.c.d/n") into a class
+    void addFlowFilter(const int& ifindex, const quint32& parent, const int& priority,
+        const QString& source, const QString& destination, const quint32& flowid);
+    void deleteFlowFilters(const int& ifindex, const quint32& parent, const int& priority);
+
+    // 0 or the negative errno of the first request that failed, the queue is empty afterwards
+    int commit();
+    QString errorString() const;
+
+    static int interfaceIndex(const QString& name);
+    static quint32 handle(const quint32& major, const quint32& minor) { return (major << 16) | minor; }
+
+private:
+    class Impl;
+    Impl* impl;
+};
+
+}
+
+#endif // rqt_netem__netlink_H
@@ -0,0 +1,58 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_netem__timeline_H
+#define rqt_netem__timeline_H
+
+#include <QString>
+#include <vector>
+
+namespace rqt_netem {
+
+// a schedule of the impairments as keyframes, e.g. a link that degrades and recovers
+class Timeline
+{
+public:
+    enum Value {
+        InboundDelay, OutboundDelay,
+        InboundLoss, OutboundLoss,
+        InboundRate, OutboundRate,
+        InboundJitter, OutboundJitter,
+        NumValues
+    };
+
+    struct Keyframe {
+        double time = 0.0;              // s from the start
+        double values[NumValues] = {};  // ms, %, kB/s (the kbps of tc) and ms as in the main window
+        bool is_ramp = true;            // linear towards the next keyframe, otherwise held
+    };
+
+    Timeline();
+
+    void clear();
+    // the keyframes are kept in the order of their time
+    void setKeyframes(const std::vector<Keyframe>& keyframes);
+    const std::vector<Keyframe>& keyframes() const { return frames; }
+    int numKeyframes() const { return (int)frames.size(); }
+    double duration() const;
+
+    // the values before the first and after the last keyframe are those of the keyframe
+    void valuesAt(const double& time, double* values) const;
+
+    // keyframe files are JSON, { "keyframes": [ { "time": 0, "inbound_delay": 5, ... } ] }
+    bool load(const QString& fileName);
+    bool save(const QString& fileName) const;
+    QString errorString() const { return error_string; }
+
+    static QString valueKey(const int& value);
+    static QString valueLabel(const int& value);
+
+private:
+    std::vector<Keyframe> frames;
+    mutable QString error_string;
+};
+
+}
+
+#endif // rqt_netem__timeline_H
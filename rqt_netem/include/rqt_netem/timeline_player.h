@@ -0,0 +1,64 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_netem__timeline_player_H
+#define rqt_netem__timeline_player_H
+
+#include <QObject>
+
+#include <functional>
+
+#include "rqt_netem/timeline.h"
+
+namespace rqt_netem {
+
+// steps a timeline or another source of values at a fixed rate: every step is due at a multiple
+// of the period from the start, so a late step delays no other, and the steps that are overtaken
+// are skipped
+class TimelinePlayer : public QObject
+{
+    Q_OBJECT
+public:
+    TimelinePlayer(QObject* parent = nullptr);
+    ~TimelinePlayer();
+
+    // called with Timeline::NumValues values, the time it takes is part of the apply time
+    typedef std::function<void(const double* values)> ApplyFunction;
+
+    // fills the Timeline::NumValues values at a time, false once nothing follows that time;
+    // the times of a run only increase, so a source may read ahead as it goes
+    typedef std::function<bool(const double& time, double* values)> SourceFunction;
+
+    void setApplyFunction(const ApplyFunction& function);
+    void setSourceFunction(const SourceFunction& function);
+    void setTimeline(const Timeline& timeline);
+    // steps per second, 1 to 100
+    void setRate(const double& rate);
+    double rate() const;
+    // a CSV of the scheduled and the actual time of each step, empty for none
+    void setLogFile(const QString& fileName);
+
+    void start();
+    void stop();
+    bool isPlaying() const;
+
+    // of the current or the last run, lateness is the actual apply time after the scheduled one
+    int numSteps() const;
+    int numSkippedSteps() const;
+    double meanLateness() const;    // ms
+    double maxLateness() const;
+
+signals:
+    void stepped(double time);
+    void finished();
+    void errored(QString error);
+
+private:
+    class Impl;
+    Impl* impl;
+};
+
+}
+
+#endif // rqt_netem__timeline_player_H
@@ -0,0 +1,67 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_netem__trace_reader_H
+#define rqt_netem__trace_reader_H
+
+#include <QFile>
+#include <QString>
+
+#include <vector>
+
+#include "rqt_netem/timeline.h"
+
+namespace rqt_netem {
+
+// reads a recorded network trace as it is replayed: a CSV with a header and one row per interval,
+// e.g. "time,delay,jitter,loss,rate" with the time in s, delay and jitter in ms, loss in % and
+// rate in kbit/s, which comes out in the kB/s of the timeline. The columns delay, jitter, loss
+// and rate set both directions, the keys of Timeline (inbound_delay, ...) a single one. Only two
+// rows are held at a time.
+class TraceReader
+{
+public:
+    TraceReader();
+    ~TraceReader();
+
+    bool open(const QString& fileName);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+    QString errorString() const { return error_string; }
+
+    // the mean of the rows over the time since the previous call, weighted by how long each
+    // of them held; the times must not decrease. False once the last row is over.
+    bool valuesAt(const double& time, double* values);
+
+    qint64 numRows() const { return num_rows; }
+    qint64 numSkippedLines() const { return num_skipped_lines; }
+
+private:
+    struct Row {
+        double time;
+        double values[Timeline::NumValues];
+    };
+
+    bool readRow(Row& row);
+
+    enum { Unused = -1, TimeColumn = -2 };
+
+    QFile file;
+    QString error_string;
+    char separator;
+    std::vector<int> columns;           // a value, TimeColumn or Unused per column
+    std::vector<int> shared_columns;    // the second value of the columns of both directions
+    Row current;
+    Row next;
+    bool has_next;
+    double first_time;
+    double interval;
+    double last_time;
+    qint64 num_rows;
+    qint64 num_skipped_lines;
+};
+
+}
+
+#endif // rqt_netem__trace_reader_H
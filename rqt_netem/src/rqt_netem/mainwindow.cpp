@@ -17,6 +17,7 @@
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QGridLayout>
+#include <QHeaderView>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -24,16 +25,25 @@
 #include <QLineEdit>
 #include <QProcess>
 #include <QPushButton>
+#include <QStatusBar>
+#include <QTableWidget>
 #include <QToolBar>
 #include <QValidator>
 
+#include <algorithm>
 #include <boost/format.hpp>
+#include <errno.h>
 #include <stdlib.h>
 #include <net/if.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/wait.h>
 
 #include "rqt_netem/bash.h"
+#include "rqt_netem/netlink.h"
+#include "rqt_netem/timeline.h"
+#include "rqt_netem/timeline_player.h"
+#include "rqt_netem/trace_reader.h"
 
 namespace {
 
@@ -112,6 +122,161 @@ struct OptionInfo {
     QString slot_distribution = "disabled";
 };
 
+// the arguments of "tc qdisc ... netem"
+QString netemText(const OptionInfo& info, const double& delayTime, const double& lossPercent, const double& rateRate)
+{
+    QString text;
+
+    if(info.limit_packets > 0.0) {
+        text += QString("limit %1").arg((int)info.limit_packets);
+    }
+
+    if(delayTime > 0.0) {
+        text += QString(" delay %1ms").arg((int)delayTime);
+        if(info.delay_jitter > 0.0) {
+            text += QString(" %1ms").arg((int)info.delay_jitter);
+            if(info.delay_correlation > 0.0) {
+                text += QString(" %1\%").arg((int)info.delay_correlation);
+            }
+        }
+        if(info.delay_distribution != "disabled") {
+            text += QString(" distribution %1").arg(info.delay_distribution);
+        }
+    }
+
+    if(lossPercent > 0.0) {
+        text += " loss";
+        if(info.loss_random != "disabled") {
+            text += " random";
+        }
+        text += QString(" %1\%").arg((int)lossPercent);
+        if(info.loss_correlation > 0.0) {
+            text += QString(" %1\%").arg((int)info.loss_correlation);
+        }
+    }
+
+    if(info.corruption_percent > 0.0) {
+        text += QString(" corrupt %1\%").arg((int)info.corruption_percent);
+        if(info.corruption_correlation > 0.0) {
+            text += QString(" %1\%").arg((int)info.corruption_correlation);
+        }
+    }
+
+    if(info.duplication_percent > 0.0) {
+        text += QString(" duplicate %1\%").arg((int)info.duplication_percent);
+        if(info.duplication_correlation > 0.0) {
+            text += QString(" %1\%").arg((int)info.duplication_correlation);
+        }
+    }
+
+    if(info.reordering_percent > 0.0) {
+        text += QString(" reorder %1\%").arg((int)info.reordering_percent);
+        if(info.reordering_correlation > 0.0) {
+            text += QString(" %1\%").arg((int)info.reordering_correlation);
+        }
+        if(info.reordering_distance > 0.0) {
+            text += QString(" gap %1").arg((int)info.reordering_distance);
+        }
+    }
+
+    if(rateRate > 0.0) {
+        text += QString(" rate %1kbps").arg((int)rateRate);
+        if(info.rate_packet_overhead > 0.0) {
+            text += QString(" %1").arg((int)info.rate_packet_overhead);
+            if(info.rate_cell_size > 0.0) {
+                text += QString(" %1").arg((int)info.rate_cell_size);
+                if(info.rate_cell_overhead > 0.0) {
+                    text += QString(" %1").arg((int)info.rate_cell_overhead);
+                }
+            }
+        }
+    }
+
+    if(info.slot_distribution != "disabled") {
+        text += QString(" slot %1").arg(info.slot_distribution);
+    } else if(info.slot_min_delay > 0.0) {
+        text += QString(" slot %1ms").arg((int)info.slot_min_delay);
+        if(info.slot_max_delay > 0.0) {
+            text += QString(" %1ms").arg((int)info.slot_max_delay);
+        }
+    }
+
+    return text;
+}
+
+// the same netem as the tc arguments built in writeCommands()
+rqt_netem::NetemParameters netemParameters(const OptionInfo& info, const double& delayTime,
+    const double& lossPercent, const double& rateRate)
+{
+    rqt_netem::NetemParameters parameters;
+    parameters.limit = (quint32)info.limit_packets;
+    if(delayTime > 0.0) {
+        parameters.delay = delayTime;
+        parameters.jitter = info.delay_jitter;
+        if(info.delay_jitter > 0.0) {
+            parameters.delay_correlation = info.delay_correlation;
+        }
+    }
+    // the table stays with a delay of 0, as a change cannot take it away without a rebuild
+    if(info.delay_distribution != "disabled") {
+        parameters.delay_distribution = info.delay_distribution;
+    }
+    if(lossPercent > 0.0) {
+        parameters.loss = lossPercent;
+        parameters.loss_correlation = info.loss_correlation;
+    }
+    parameters.corrupt = info.corruption_percent;
+    parameters.corrupt_correlation = info.corruption_correlation;
+    parameters.duplicate = info.duplication_percent;
+    parameters.duplicate_correlation = info.duplication_correlation;
+    if(info.reordering_percent > 0.0) {
+        parameters.reorder = info.reordering_percent;
+        parameters.reorder_correlation = info.reordering_correlation;
+        parameters.gap = (quint32)info.reordering_distance;
+    }
+    if(rateRate > 0.0) {
+        // "kbps" of tc are kilobytes per second
+        parameters.rate = rateRate * 1000.0;
+        parameters.packet_overhead = (int)info.rate_packet_overhead;
+        parameters.cell_size = (quint32)info.rate_cell_size;
+        parameters.cell_overhead = (int)info.rate_cell_overhead;
+    }
+    if(info.slot_distribution != "disabled") {
+        parameters.slot_distribution = info.slot_distribution;
+    }
+    parameters.slot_min_delay = info.slot_min_delay;
+    parameters.slot_max_delay = info.slot_max_delay;
+    return parameters;
+}
+
+// what one side has programmed, the ifb the inbound and the interface the outbound netem
+struct NetemState {
+    rqt_netem::NetemParameters limit;   // 10:
+    rqt_netem::NetemParameters netem;   // 20:
+    QString text;
+    QString source;
+    QString destination;
+};
+
+// a change keeps what it leaves out: a distribution table cannot be removed that way,
+// and tc sends the other options only when they are non-zero
+bool needsRebuild(const rqt_netem::NetemParameters& from, const rqt_netem::NetemParameters& to,
+    const bool& isNetlink)
+{
+    if((!from.delay_distribution.isEmpty() && to.delay_distribution.isEmpty())
+            || (!from.slot_distribution.isEmpty() && to.slot_distribution.isEmpty())) {
+        return true;
+    }
+    if(isNetlink) {
+        return false;
+    }
+    auto cleared = [](const double& from, const double& to){ return from > 0.0 && to <= 0.0; };
+    return cleared(from.delay_correlation + from.loss_correlation + from.duplicate_correlation,
+            to.delay_correlation + to.loss_correlation + to.duplicate_correlation)
+        || cleared(from.reorder, to.reorder) || cleared(from.corrupt, to.corrupt)
+        || cleared(from.rate, to.rate) || cleared(from.slot_min_delay, to.slot_min_delay);
+}
+
 struct ComboInfo {
     const QString label;
     int row;
@@ -226,6 +391,32 @@ private:
     OptionInfo outInfo;
 };
 
+class TimelineDialog : public QDialog
+{
+public:
+    TimelineDialog(QWidget* parent = nullptr);
+
+    void setTimeline(const Timeline& timeline);
+    Timeline timeline() const;
+
+    QDoubleSpinBox* rateSpin;
+    QLineEdit* logLine;
+
+private:
+    void on_addButton_clicked();
+    void on_removeButton_clicked();
+    void on_openButton_clicked();
+    void on_saveButton_clicked();
+    void on_logButton_clicked();
+
+    void addRow(const Timeline::Keyframe& frame);
+
+    enum { TimeColumn, RampColumn = Timeline::NumValues + 1, NumColumns };
+
+    QTableWidget* table;
+    QDialogButtonBox* buttonBox;
+};
+
 class MainWindow::Impl
 {
 public:
@@ -243,8 +434,21 @@ public:
     void startBash();
     void stopBash();
     void close();
+    void closeCommands();
     void write();
-    void execute(const QString& text);
+    int writeNetlink();
+    void writeCommands();
+    void update();
+    void updateNetlink(const int& ifindex, const NetemState& from, const NetemState& to);
+    void updateCommands(const QString& dev, const NetemState& from, const NetemState& to, QStringList& list);
+    void makeStates(NetemState& inState, NetemState& outState);
+    void editTimeline();
+    void playTimeline();
+    void playTrace();
+    bool canPlay();
+    void applyTimeline(const double* values);
+    int execute(const QString& text);
+    void report(const QString& message);
 
     bool save(const QString& fileName);
     bool load(const QString& fileName);
@@ -271,6 +475,9 @@ public:
     QAction* stopAct;
     QAction* configAct;
     QAction* clearAct;
+    QAction* timelineAct;
+    QAction* playAct;
+    QAction* traceAct;
 
     QComboBox* combos[NumCombos];
     QLineEdit* lines[NumLines];
@@ -278,10 +485,22 @@ public:
     QProcess process;
 
     bool is_started;
+    bool is_applied;
+    bool is_netlink;
+    bool created_ifb;
+    NetemState in_state;
+    NetemState out_state;
 
     OptionInfo inInfo;
     OptionInfo outInfo;
     Bash* bash;
+    Netlink netlink;
+    Timeline timeline;
+    TimelinePlayer player;
+    QString timeline_log;
+    TraceReader trace;
+    // the values of the timeline while it plays, the spins and the Advanced Config keep their own
+    double timeline_values[Timeline::NumValues];
 };
 
 MainWindow::MainWindow(QWidget* parent)
@@ -302,6 +521,10 @@ MainWindow::Impl::Impl(MainWindow* self)
     self->setWindowTitle("Network Emulator");
 
     is_started = false;
+    is_applied = false;
+    is_netlink = false;
+    created_ifb = false;
+    std::fill(timeline_values, timeline_values + Timeline::NumValues, 0.0);
     bash = new Bash;
 
     QGridLayout* gridLayout = new QGridLayout;
@@ -321,6 +544,7 @@ MainWindow::Impl::Impl(MainWindow* self)
         LineInfo& info = lineInfo[i];
         gridLayout->addWidget(new QLabel(info.label), info.row, info.cln - 1);
         gridLayout->addWidget(line, info.row, info.cln);
+        self->connect(line, &QLineEdit::editingFinished, [&](){ update(); });
     }
 
     QComboBox* ifcCombo = combos[Interface];
@@ -346,7 +570,7 @@ MainWindow::Impl::Impl(MainWindow* self)
     gridLayout2->addWidget(new QLabel("Inbound"), 0, 1);
     gridLayout2->addWidget(new QLabel("Outbound"), 0, 2);
 
-    const QStringList list = { "Dealy Time [ms]", "Loss Percent [%]", "Rate Rate [kbit/s]" };
+    const QStringList list = { "Dealy Time [ms]", "Loss Percent [%]", "Rate Rate [kB/s]" };
     for(int i = 0; i < 3; ++i) {
         gridLayout2->addWidget(new QLabel(list.at(i)), i + 1, 0);
     }
@@ -358,10 +582,27 @@ MainWindow::Impl::Impl(MainWindow* self)
         spin->setRange(info.lower, info.upper);
         spin->setValue(info.value);
         gridLayout2->addWidget(spin, info.row, info.cln);
+        self->connect(spin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), [&](double){ update(); });
     }
 
     self->connect(&process, &QProcess::stateChanged, [&](QProcess::ProcessState newState){ on_process_stateChanged(newState); });
 
+    player.setApplyFunction([&](const double* values){ applyTimeline(values); });
+    self->connect(&player, &TimelinePlayer::finished, [&](){
+        QString message = QString("Playback finished: %1 steps, %2 skipped, lateness mean %3 ms, max %4 ms")
+            .arg(player.numSteps()).arg(player.numSkippedSteps())
+            .arg(player.meanLateness(), 0, 'f', 3).arg(player.maxLateness(), 0, 'f', 3);
+        // the counts of the trace go with closing it
+        if(trace.isOpen()) {
+            message += QString(", trace of %1 rows, %2 lines skipped").arg(trace.numRows()).arg(trace.numSkippedLines());
+        }
+        report(message);
+        trace.close();
+        // the spins and the Advanced Config are back in force
+        update();
+    });
+    self->connect(&player, &TimelinePlayer::errored, [&](QString error){ report(error); });
+
     auto layout = new QVBoxLayout;
     layout->addLayout(gridLayout);
     layout->addLayout(gridLayout2);
@@ -408,12 +649,19 @@ void MainWindow::Impl::save()
 
 void MainWindow::Impl::start()
 {
+    // a running emulation is changed in place instead of being torn down
+    if(is_applied) {
+        update();
+        return;
+    }
     stop();
     startBash();
 }
 
 void MainWindow::Impl::stop()
 {
+    player.stop();
+    trace.close();
     close();
     stopBash();
 }
@@ -440,6 +688,7 @@ void MainWindow::Impl::config()
         dialog.make();
         inInfo = dialog.inboundInfo();
         outInfo = dialog.outboundInfo();
+        update();
     }
 }
 
@@ -457,205 +706,138 @@ void MainWindow::Impl::stopBash()
 
 void MainWindow::Impl::close()
 {
-    QString ifc_name = combos[Interface]->currentText();
-    QString ifb_name = combos[IntermediateFunctionalBlock]->currentText();
-
-    if(is_started) {
-        QStringList list;
-        // clear settings
-        list << QString("sudo tc qdisc del dev %1 ingress").arg(ifc_name);
-        list << QString("sudo tc qdisc del dev %1 root").arg(ifb_name);
-        list << QString("sudo tc qdisc del dev %1 root").arg(ifc_name);
-
-        // finalize
-        list << QString("sudo ip link set dev %1 down").arg(ifb_name);
-        list << "sudo rmmod ifb";
-        for(int i = 0; i < list.size(); ++i) {
-            execute(list.at(i));
-        }
+    if(!is_started) {
+        return;
     }
-}
-
-void MainWindow::Impl::write()
-{
-    double in_delay_time = spins[Inbound_DelayTIme]->value();
-    double in_loss_percent = spins[Inbound_LossPercent]->value();
-    double in_rate_rate = spins[Inbound_RateRate]->value();
-    double out_delay_time = spins[Outbound_DelayTIme]->value();
-    double out_loss_percent = spins[Outbound_LossPercent]->value();
-    double out_rate_rate = spins[Outbound_RateRate]->value();
-
-    QString src_ip_name = lines[Source]->text();
-    QString dst_ip_name = lines[Destination]->text();
-    QString ifc_name = combos[Interface]->currentText();
-    QString ifb_name = combos[IntermediateFunctionalBlock]->currentText();
-
-    QString in_delay_distribution = inInfo.delay_distribution;
-    QString in_loss_random = inInfo.loss_random;
-    QString in_slot_distribution = inInfo.slot_distribution;
-    QString out_delay_distribution  = outInfo.delay_distribution;
-    QString out_loss_random = outInfo.loss_random;
-    QString out_slot_distribution = outInfo.slot_distribution;
-
-    QString in_text;
-    QString out_text;
-
-    // inbound commands
-    if(inInfo.limit_packets > 0.0) {
-        in_text += QString("limit %1").arg((int)inInfo.limit_packets);
+    is_applied = false;
+    if(!is_netlink) {
+        closeCommands();
+        return;
     }
 
-    if(in_delay_time > 0.0) {
-        in_text += QString(" delay %1ms").arg((int)in_delay_time);
-        if(inInfo.delay_jitter > 0.0) {
-            in_text += QString(" %1ms").arg((int)inInfo.delay_jitter);
-            if(inInfo.delay_correlation > 0.0) {
-                in_text += QString(" %1\%").arg((int)inInfo.delay_correlation);
-            }
-        }
-        if(in_delay_distribution != "disabled") {
-            in_text += QString(" distribution %1").arg(in_delay_distribution);
-        }
-    }
+    int ifc_index = Netlink::interfaceIndex(combos[Interface]->currentText());
+    int ifb_index = Netlink::interfaceIndex(combos[IntermediateFunctionalBlock]->currentText());
 
-    if(in_loss_percent > 0.0) {
-        in_text += " loss";
-        if(in_loss_random != "disabled") {
-            in_text += " random";
-        }
-        in_text += QString(" %1\%").arg((int)in_loss_percent);
-        if(inInfo.loss_correlation > 0.0) {
-            in_text += QString(" %1\%").arg((int)inInfo.loss_correlation);
-        }
+    // clear settings
+    if(ifc_index > 0) {
+        netlink.deleteIngressQdisc(ifc_index);
+        netlink.deleteRootQdisc(ifc_index);
     }
+    if(ifb_index > 0) {
+        netlink.deleteRootQdisc(ifb_index);
 
-    if(inInfo.corruption_percent > 0.0) {
-        in_text += QString(" corrupt %1\%").arg((int)inInfo.corruption_percent);
-        if(inInfo.corruption_correlation > 0.0) {
-            in_text += QString(" %1\%").arg((int)inInfo.corruption_correlation);
+        // finalize, an ifb that was there before is left as it was found apart from its state
+        netlink.setLinkUp(ifb_index, false);
+        if(created_ifb) {
+            netlink.deleteLink(ifb_index);
         }
     }
-
-    if(inInfo.duplication_percent > 0.0) {
-        in_text += QString(" duplicate %1\%").arg((int)inInfo.duplication_percent);
-        if(inInfo.duplication_correlation > 0.0) {
-            in_text += QString(" %1\%").arg((int)inInfo.duplication_correlation);
-        }
+    if(netlink.commit() != 0) {
+        report(netlink.errorString());
     }
+    netlink.close();
+    is_netlink = false;
+    created_ifb = false;
+}
 
-    if(inInfo.reordering_percent > 0.0) {
-        in_text += QString(" reorder %1\%").arg((int)inInfo.reordering_percent);
-        if(inInfo.reordering_correlation > 0.0) {
-            in_text += QString(" %1\%").arg((int)inInfo.reordering_correlation);
-        }
-        if(inInfo.reordering_distance > 0.0) {
-            in_text += QString(" gap %1").arg((int)inInfo.reordering_distance);
-        }
-    }
+void MainWindow::Impl::closeCommands()
+{
+    QString ifc_name = combos[Interface]->currentText();
+    QString ifb_name = combos[IntermediateFunctionalBlock]->currentText();
 
-    if(in_rate_rate > 0.0) {
-        in_text += QString(" rate %1kbps").arg((int)in_rate_rate);
-        if(inInfo.rate_packet_overhead > 0.0) {
-            in_text += QString(" %1").arg((int)inInfo.rate_packet_overhead);
-            if(inInfo.rate_cell_size > 0.0) {
-                in_text += QString(" %1").arg((int)inInfo.rate_cell_size);
-                if(inInfo.rate_cell_overhead > 0.0) {
-                    in_text += QString(" %1").arg((int)inInfo.rate_cell_overhead);
-                }
-            }
-        }
+    QStringList list;
+    // clear settings
+    list << QString("sudo tc qdisc del dev %1 ingress").arg(ifc_name);
+    list << QString("sudo tc qdisc del dev %1 root").arg(ifb_name);
+    list << QString("sudo tc qdisc del dev %1 root").arg(ifc_name);
+
+    // finalize
+    list << QString("sudo ip link set dev %1 down").arg(ifb_name);
+    list << "sudo rmmod ifb";
+    for(int i = 0; i < list.size(); ++i) {
+        execute(list.at(i));
     }
+}
 
-    if(in_slot_distribution != "disabled") {
-        in_text += QString(" slot %1").arg(in_slot_distribution);
-    } else if(inInfo.slot_min_delay > 0.0) {
-        in_text += QString(" slot %1ms").arg((int)inInfo.slot_min_delay);
-        if(inInfo.slot_max_delay > 0.0) {
-            in_text += QString(" %1ms").arg((int)inInfo.slot_max_delay);
-        }
-    }
+void MainWindow::Impl::write()
+{
+    makeStates(in_state, out_state);
 
-    // outbound commands
-    if(outInfo.limit_packets > 0.0) {
-        out_text += QString("limit %1").arg((int)outInfo.limit_packets);
+    QString ifc_name = combos[Interface]->currentText();
+    if(Netlink::interfaceIndex(ifc_name) == 0) {
+        report(QString("%1: no such interface").arg(ifc_name));
+        return;
     }
 
-    if(out_delay_time > 0.0) {
-        out_text += QString(" delay %1ms").arg((int)out_delay_time);
-        if(outInfo.delay_jitter > 0.0) {
-            out_text += QString(" %1ms").arg((int)outInfo.delay_jitter);
-            if(outInfo.delay_correlation > 0.0) {
-                out_text += QString(" %1\%").arg((int)outInfo.delay_correlation);
-            }
-        }
-        if(out_delay_distribution != "disabled") {
-            out_text += QString(" distribution %1").arg(out_delay_distribution);
-        }
+    int ret = writeNetlink();
+    if(ret == 0) {
+        is_applied = true;
+        return;
     }
 
-    if(out_loss_percent > 0.0) {
-        out_text += " loss";
-        if(out_loss_random != "disabled") {
-            out_text += " random";
-        }
-        out_text += QString(" %1\%").arg((int)out_loss_percent);
-        if(outInfo.loss_correlation > 0.0) {
-            out_text += QString(" %1\%").arg((int)outInfo.loss_correlation);
-        }
+    // the rtnetlink requests need CAP_NET_ADMIN, without it the privileges of sudo tc are used
+    if(ret == -EPERM || ret == -EACCES || ret == -EPROTONOSUPPORT) {
+        netlink.close();
+        is_netlink = false;
+        writeCommands();
+        is_applied = true;
+        return;
     }
 
-    if(outInfo.corruption_percent > 0.0) {
-        out_text += QString(" corrupt %1\%").arg((int)outInfo.corruption_percent);
-        if(outInfo.corruption_correlation > 0.0) {
-            out_text += QString(" %1\%").arg((int)outInfo.corruption_correlation);
-        }
+    // any other failure leaves nothing applied, the part of the topology that was built goes again
+    QString message = netlink.errorString();
+    if(is_netlink) {
+        close();
     }
+    report(message);
+}
 
-    if(outInfo.duplication_percent > 0.0) {
-        out_text += QString(" duplicate %1\%").arg((int)outInfo.duplication_percent);
-        if(outInfo.duplication_correlation > 0.0) {
-            out_text += QString(" %1\%").arg((int)outInfo.duplication_correlation);
-        }
-    }
+int MainWindow::Impl::writeNetlink()
+{
+    QString ifc_name = combos[Interface]->currentText();
+    QString ifb_name = combos[IntermediateFunctionalBlock]->currentText();
 
-    if(outInfo.reordering_percent > 0.0) {
-        out_text += QString(" reorder %1\%").arg((int)outInfo.reordering_percent);
-        if(outInfo.reordering_correlation > 0.0) {
-            out_text += QString(" %1\%").arg((int)outInfo.reordering_correlation);
-        }
-        if(outInfo.reordering_distance > 0.0) {
-            out_text += QString(" gap %1").arg((int)outInfo.reordering_distance);
-        }
+    int ret = netlink.open();
+    if(ret != 0) {
+        return ret;
     }
+    is_netlink = true;
 
-    if(out_rate_rate > 0.0) {
-        out_text += QString(" rate %1kbps").arg((int)out_rate_rate);
-        if(outInfo.rate_packet_overhead > 0.0) {
-            out_text += QString(" %1").arg((int)outInfo.rate_packet_overhead);
-            if(outInfo.rate_cell_size > 0.0) {
-                out_text += QString(" %1").arg((int)outInfo.rate_cell_size);
-                if(outInfo.rate_cell_overhead > 0.0) {
-                    out_text += QString(" %1").arg((int)outInfo.rate_cell_overhead);
-                }
-            }
-        }
-    }
+    int ifc_index = Netlink::interfaceIndex(ifc_name);
 
-    if(out_slot_distribution != "disabled") {
-        out_text += QString(" slot %1").arg(out_slot_distribution);
-    } else if(outInfo.slot_min_delay > 0.0) {
-        out_text += QString(" slot %1ms").arg((int)outInfo.slot_min_delay);
-        if(outInfo.slot_max_delay > 0.0) {
-            out_text += QString(" %1ms").arg((int)outInfo.slot_max_delay);
+    // initialize, the kernel loads ifb and act_mirred on demand
+    int ifb_index = Netlink::interfaceIndex(ifb_name);
+    if(ifb_index == 0) {
+        netlink.addLink(ifb_name, "ifb");
+        ret = netlink.commit();
+        if(ret != 0) {
+            return ret;
         }
+        created_ifb = true;
+        ifb_index = Netlink::interfaceIndex(ifb_name);
     }
+    netlink.setLinkUp(ifb_index, true);
 
-    if(!checkAddress(src_ip_name)) {
-        src_ip_name = "0.0.0.0/0";
-    }
-    if(!checkAddress(dst_ip_name)) {
-        dst_ip_name = "0.0.0.0/0";
-    }
+    // apply settings
+    const quint32 root = Netlink::handle(1, 0);
+    netlink.addIngressQdisc(ifc_index);
+    netlink.addRedirectFilter(ifc_index, ifb_index);
+    netlink.addPrioQdisc(ifb_index, root, 16);
+    netlink.addNetemQdisc(ifb_index, Netlink::handle(1, 1), Netlink::handle(0x10, 0), in_state.limit);
+    netlink.addNetemQdisc(ifb_index, Netlink::handle(1, 2), Netlink::handle(0x20, 0), in_state.netem);
+    netlink.addFlowFilter(ifb_index, root, 2, in_state.source, in_state.destination, Netlink::handle(1, 2));
+
+    netlink.addPrioQdisc(ifc_index, root, 16);
+    netlink.addNetemQdisc(ifc_index, Netlink::handle(1, 1), Netlink::handle(0x10, 0), out_state.limit);
+    netlink.addNetemQdisc(ifc_index, Netlink::handle(1, 2), Netlink::handle(0x20, 0), out_state.netem);
+    netlink.addFlowFilter(ifc_index, root, 2, out_state.source, out_state.destination, Netlink::handle(1, 2));
+    return netlink.commit();
+}
+
+void MainWindow::Impl::writeCommands()
+{
+    QString ifc_name = combos[Interface]->currentText();
+    QString ifb_name = combos[IntermediateFunctionalBlock]->currentText();
 
     QStringList list;
     // initialize
@@ -671,30 +853,142 @@ void MainWindow::Impl::write()
     list << QString("sudo tc qdisc add dev %1 root handle 1: prio bands 16 priomap 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0")
         .arg(ifb_name);
     list << QString("sudo tc qdisc add dev %1 parent 1:1 handle 10: netem limit %2")
-        .arg(ifb_name).arg((int)inInfo.limit_packets);
+        .arg(ifb_name).arg(in_state.limit.limit);
+    list << QString("sudo tc qdisc add dev %1 parent 1:2 handle 20: netem %2")
+        .arg(ifb_name).arg(in_state.text);
+    list << QString("sudo tc filter add dev %1 protocol ip parent 1: prio 2 u32 match ip src %2 match ip dst %3 flowid 1:2")
+        .arg(ifb_name).arg(in_state.source).arg(in_state.destination);
 
-    if((!src_ip_name.isEmpty()) && (!dst_ip_name.isEmpty())) {
-        list << QString("sudo tc qdisc add dev %1 parent 1:2 handle 20: netem %2")
-            .arg(ifb_name).arg(in_text);
-        list << QString("sudo tc filter add dev %1 protocol ip parent 1: prio 2 u32 match ip src %2 match ip dst %3 flowid 1:2")
-            .arg(ifb_name).arg(dst_ip_name).arg(src_ip_name);
-    }
     list << QString("sudo tc qdisc add dev %1 root handle 1: prio bands 16 priomap 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0")
         .arg(ifc_name);
     list << QString("sudo tc qdisc add dev %1 parent 1:1 handle 10: netem limit %2")
-        .arg(ifc_name).arg((int)outInfo.limit_packets);
-    if((!src_ip_name.isEmpty()) && (!dst_ip_name.isEmpty())) {
-        list << QString("sudo tc qdisc add dev %1 parent 1:2 handle 20: netem %2")
-            .arg(ifc_name).arg(out_text);
-        list << QString("sudo tc filter add dev %1 protocol ip parent 1: prio 2 u32 match ip src %2 match ip dst %3 flowid 1:2")
-            .arg(ifc_name).arg(src_ip_name).arg(dst_ip_name);
-    }
+        .arg(ifc_name).arg(out_state.limit.limit);
+    list << QString("sudo tc qdisc add dev %1 parent 1:2 handle 20: netem %2")
+        .arg(ifc_name).arg(out_state.text);
+    list << QString("sudo tc filter add dev %1 protocol ip parent 1: prio 2 u32 match ip src %2 match ip dst %3 flowid 1:2")
+        .arg(ifc_name).arg(out_state.source).arg(out_state.destination);
     for(int i = 0; i < list.size(); ++i) {
         execute(list.at(i));
     }
 }
 
-void MainWindow::Impl::execute(const QString& text)
+void MainWindow::Impl::update()
+{
+    if(!is_applied) {
+        return;
+    }
+
+    NetemState in;
+    NetemState out;
+    makeStates(in, out);
+    if(needsRebuild(in_state.netem, in.netem, is_netlink) || needsRebuild(out_state.netem, out.netem, is_netlink)) {
+        close();
+        write();
+        return;
+    }
+
+    // only the netem qdiscs and the filters that differ are touched, the queues are kept
+    if(is_netlink) {
+        int ifc_index = Netlink::interfaceIndex(combos[Interface]->currentText());
+        int ifb_index = Netlink::interfaceIndex(combos[IntermediateFunctionalBlock]->currentText());
+        updateNetlink(ifb_index, in_state, in);
+        updateNetlink(ifc_index, out_state, out);
+        if(netlink.commit() != 0) {
+            report(netlink.errorString());
+            return;
+        }
+    } else {
+        QStringList list;
+        updateCommands(combos[IntermediateFunctionalBlock]->currentText(), in_state, in, list);
+        updateCommands(combos[Interface]->currentText(), out_state, out, list);
+        for(int i = 0; i < list.size(); ++i) {
+            execute(list.at(i));
+        }
+    }
+    in_state = in;
+    out_state = out;
+}
+
+void MainWindow::Impl::updateNetlink(const int& ifindex, const NetemState& from, const NetemState& to)
+{
+    if(from.limit != to.limit) {
+        netlink.changeNetemQdisc(ifindex, Netlink::handle(1, 1), Netlink::handle(0x10, 0), to.limit, from.limit);
+    }
+    if(from.netem != to.netem) {
+        netlink.changeNetemQdisc(ifindex, Netlink::handle(1, 2), Netlink::handle(0x20, 0), to.netem, from.netem);
+    }
+    if(from.source != to.source || from.destination != to.destination) {
+        // both go out in one batch, the gap without the filter is that of a single sendmsg
+        netlink.deleteFlowFilters(ifindex, Netlink::handle(1, 0), 2);
+        netlink.addFlowFilter(ifindex, Netlink::handle(1, 0), 2, to.source, to.destination, Netlink::handle(1, 2));
+    }
+}
+
+void MainWindow::Impl::updateCommands(const QString& dev, const NetemState& from, const NetemState& to,
+    QStringList& list)
+{
+    if(from.limit != to.limit) {
+        list << QString("sudo tc qdisc change dev %1 parent 1:1 handle 10: netem limit %2")
+            .arg(dev).arg(to.limit.limit);
+    }
+    if(from.netem != to.netem) {
+        list << QString("sudo tc qdisc change dev %1 parent 1:2 handle 20: netem %2")
+            .arg(dev).arg(to.text);
+    }
+    if(from.source != to.source || from.destination != to.destination) {
+        list << QString("sudo tc filter del dev %1 protocol ip parent 1: prio 2").arg(dev);
+        list << QString("sudo tc filter add dev %1 protocol ip parent 1: prio 2 u32 match ip src %2 match ip dst %3 flowid 1:2")
+            .arg(dev).arg(to.source).arg(to.destination);
+    }
+}
+
+void MainWindow::Impl::makeStates(NetemState& inState, NetemState& outState)
+{
+    // a playing timeline overrides the spins and the jitters without touching either
+    OptionInfo in_info = inInfo;
+    OptionInfo out_info = outInfo;
+    double values[Timeline::NumValues] = {};
+    for(int i = 0; i < NumSpins; ++i) {
+        values[i] = spins[i]->value();
+    }
+    if(player.isPlaying()) {
+        std::copy(timeline_values, timeline_values + Timeline::NumValues, values);
+        in_info.delay_jitter = values[Timeline::InboundJitter];
+        out_info.delay_jitter = values[Timeline::OutboundJitter];
+    }
+    double in_delay_time = values[Timeline::InboundDelay];
+    double in_loss_percent = values[Timeline::InboundLoss];
+    double in_rate_rate = values[Timeline::InboundRate];
+    double out_delay_time = values[Timeline::OutboundDelay];
+    double out_loss_percent = values[Timeline::OutboundLoss];
+    double out_rate_rate = values[Timeline::OutboundRate];
+
+    QString src_ip_name = lines[Source]->text();
+    QString dst_ip_name = lines[Destination]->text();
+    if(!checkAddress(src_ip_name)) {
+        src_ip_name = "0.0.0.0/0";
+    }
+    if(!checkAddress(dst_ip_name)) {
+        dst_ip_name = "0.0.0.0/0";
+    }
+
+    // the inbound traffic comes from the destination
+    inState.limit = NetemParameters();
+    inState.limit.limit = (quint32)in_info.limit_packets;
+    inState.netem = netemParameters(in_info, in_delay_time, in_loss_percent, in_rate_rate);
+    inState.text = netemText(in_info, in_delay_time, in_loss_percent, in_rate_rate);
+    inState.source = dst_ip_name;
+    inState.destination = src_ip_name;
+
+    outState.limit = NetemParameters();
+    outState.limit.limit = (quint32)out_info.limit_packets;
+    outState.netem = netemParameters(out_info, out_delay_time, out_loss_percent, out_rate_rate);
+    outState.text = netemText(out_info, out_delay_time, out_loss_percent, out_rate_rate);
+    outState.source = src_ip_name;
+    outState.destination = dst_ip_name;
+}
+
+int MainWindow::Impl::execute(const QString& text)
 {
     // QByteArray data;
     // data.append(QString(program.c_str()));
@@ -702,6 +996,16 @@ void MainWindow::Impl::execute(const QString& text)
     // process.write(data);
     int ret = system(text.toStdString().c_str());
     // qDebug() << text;
+    if(ret != 0) {
+        report(QString("%1: exit status %2").arg(text).arg(WIFEXITED(ret) ? WEXITSTATUS(ret) : ret));
+    }
+    return ret;
+}
+
+void MainWindow::Impl::report(const QString& message)
+{
+    qWarning("%s", message.toLocal8Bit().constData());
+    self->statusBar()->showMessage(message);
 }
 
 bool MainWindow::Impl::save(const QString& fileName)
@@ -875,6 +1179,86 @@ void MainWindow::Impl::on_process_stateChanged(QProcess::ProcessState newState)
     }
 }
 
+void MainWindow::Impl::editTimeline()
+{
+    TimelineDialog dialog(self);
+    dialog.setTimeline(timeline);
+    dialog.rateSpin->setValue(player.rate());
+    dialog.logLine->setText(timeline_log);
+
+    if(dialog.exec()) {
+        timeline = dialog.timeline();
+        player.setRate(dialog.rateSpin->value());
+        timeline_log = dialog.logLine->text();
+    }
+}
+
+bool MainWindow::Impl::canPlay()
+{
+    if(player.isPlaying()) {
+        player.stop();
+        trace.close();
+        update();
+        self->statusBar()->showMessage("Playback stopped");
+        return false;
+    }
+    if(!is_applied) {
+        report("Start netem before playing a timeline or a trace");
+        return false;
+    }
+    return true;
+}
+
+void MainWindow::Impl::playTimeline()
+{
+    if(!canPlay()) {
+        return;
+    }
+    if(timeline.numKeyframes() == 0) {
+        report("The timeline has no keyframes");
+        return;
+    }
+
+    player.setTimeline(timeline);
+    player.setLogFile(timeline_log);
+    player.start();
+}
+
+void MainWindow::Impl::playTrace()
+{
+    if(!canPlay()) {
+        return;
+    }
+
+    static QString dir = "/home";
+    QString fileName = QFileDialog::getOpenFileName(self, "Open Trace",
+        dir,
+        "CSV Files (*.csv);;All Files (*)");
+
+    if(fileName.isEmpty()) {
+        return;
+    }
+    QFileInfo info(fileName);
+    dir = info.absolutePath();
+    if(!trace.open(fileName)) {
+        report(trace.errorString());
+        return;
+    }
+
+    // the trace is resampled at the step rate of the timeline as it is read
+    player.setSourceFunction([&](const double& time, double* values){ return trace.valuesAt(time, values); });
+    player.setLogFile(timeline_log);
+    player.start();
+}
+
+void MainWindow::Impl::applyTimeline(const double* values)
+{
+    // the values come in the order of the spins, then the jitters; the spins keep the profile
+    // of the user, which is back in force once the playback is over
+    std::copy(values, values + Timeline::NumValues, timeline_values);
+    update();
+}
+
 void MainWindow::Impl::createActions()
 {
     const QIcon openIcon = QIcon::fromTheme("document-open");
@@ -908,6 +1292,21 @@ void MainWindow::Impl::createActions()
     configAct = new QAction(configIcon, "&Config", self);
     configAct->setStatusTip("Show the config dialog");
     self->connect(configAct, &QAction::triggered, [&](){ config(); });
+
+    const QIcon timelineIcon = QIcon::fromTheme("x-office-calendar");
+    timelineAct = new QAction(timelineIcon, "&Timeline", self);
+    timelineAct->setStatusTip("Edit the impairment timeline");
+    self->connect(timelineAct, &QAction::triggered, [&](){ editTimeline(); });
+
+    const QIcon playIcon = QIcon::fromTheme("media-seek-forward");
+    playAct = new QAction(playIcon, "&Play", self);
+    playAct->setStatusTip("Play the timeline on the running netem, or stop playing it");
+    self->connect(playAct, &QAction::triggered, [&](){ playTimeline(); });
+
+    const QIcon traceIcon = QIcon::fromTheme("document-import");
+    traceAct = new QAction(traceIcon, "T&race...", self);
+    traceAct->setStatusTip("Replay a recorded trace on the running netem, or stop playing it");
+    self->connect(traceAct, &QAction::triggered, [&](){ playTrace(); });
 }
 
 void MainWindow::Impl::createToolBars()
@@ -920,6 +1319,10 @@ void MainWindow::Impl::createToolBars()
     emulatorToolBar->addAction(stopAct);
     emulatorToolBar->addAction(clearAct);
     emulatorToolBar->addAction(configAct);
+    emulatorToolBar->addSeparator();
+    emulatorToolBar->addAction(timelineAct);
+    emulatorToolBar->addAction(playAct);
+    emulatorToolBar->addAction(traceAct);
 }
 
 AdvancedConfigDialog::AdvancedConfigDialog(QWidget* parent)
@@ -1085,4 +1488,176 @@ void AdvancedConfigDialog::make()
     outInfo.slot_distribution = combos[Outbound_SlotDistribution]->currentText();
 }
 
+TimelineDialog::TimelineDialog(QWidget* parent)
+    : QDialog(parent)
+{
+    QStringList labels;
+    labels << "Time [s]";
+    for(int i = 0; i < Timeline::NumValues; ++i) {
+        labels << Timeline::valueLabel(i);
+    }
+    labels << "Ramp";
+
+    table = new QTableWidget(0, NumColumns);
+    table->setHorizontalHeaderLabels(labels);
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    QPushButton* addButton = new QPushButton("&Add");
+    QPushButton* removeButton = new QPushButton("&Remove");
+    QPushButton* openButton = new QPushButton("&Open...");
+    QPushButton* saveButton = new QPushButton("&Save...");
+    connect(addButton, &QPushButton::clicked, [&](){ on_addButton_clicked(); });
+    connect(removeButton, &QPushButton::clicked, [&](){ on_removeButton_clicked(); });
+    connect(openButton, &QPushButton::clicked, [&](){ on_openButton_clicked(); });
+    connect(saveButton, &QPushButton::clicked, [&](){ on_saveButton_clicked(); });
+
+    auto buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(addButton);
+    buttonLayout->addWidget(removeButton);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(openButton);
+    buttonLayout->addWidget(saveButton);
+
+    rateSpin = new QDoubleSpinBox;
+    rateSpin->setRange(1.0, 100.0);
+    rateSpin->setValue(10.0);
+    logLine = new QLineEdit;
+    QPushButton* logButton = new QPushButton("...");
+    connect(logButton, &QPushButton::clicked, [&](){ on_logButton_clicked(); });
+
+    QGridLayout* gridLayout = new QGridLayout;
+    gridLayout->addWidget(new QLabel("Step Rate [Hz]"), 0, 0);
+    gridLayout->addWidget(rateSpin, 0, 1);
+    gridLayout->addWidget(new QLabel("Step Log"), 1, 0);
+    gridLayout->addWidget(logLine, 1, 1);
+    gridLayout->addWidget(logButton, 1, 2);
+
+    buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok
+                                     | QDialogButtonBox::Cancel);
+
+    connect(buttonBox, &QDialogButtonBox::accepted, [&](){ accept(); });
+    connect(buttonBox, &QDialogButtonBox::rejected, [&](){ reject(); });
+
+    auto mainLayout = new QVBoxLayout;
+    mainLayout->addWidget(table);
+    mainLayout->addLayout(buttonLayout);
+    mainLayout->addLayout(gridLayout);
+    mainLayout->addWidget(buttonBox);
+
+    setLayout(mainLayout);
+    setWindowTitle("Timeline");
+    resize(960, 480);
+}
+
+void TimelineDialog::setTimeline(const Timeline& timeline)
+{
+    table->setRowCount(0);
+    for(const Timeline::Keyframe& frame : timeline.keyframes()) {
+        addRow(frame);
+    }
+}
+
+Timeline TimelineDialog::timeline() const
+{
+    std::vector<Timeline::Keyframe> keyframes;
+    for(int i = 0; i < table->rowCount(); ++i) {
+        Timeline::Keyframe frame;
+        frame.time = table->item(i, TimeColumn)->text().toDouble();
+        for(int j = 0; j < Timeline::NumValues; ++j) {
+            frame.values[j] = table->item(i, j + 1)->text().toDouble();
+        }
+        frame.is_ramp = table->item(i, RampColumn)->checkState() == Qt::Checked;
+        keyframes.push_back(frame);
+    }
+
+    Timeline timeline;
+    timeline.setKeyframes(keyframes);
+    return timeline;
+}
+
+void TimelineDialog::on_addButton_clicked()
+{
+    // a new keyframe continues from the last one a second later
+    Timeline::Keyframe frame;
+    int numRows = table->rowCount();
+    if(numRows > 0) {
+        frame = timeline().keyframes().back();
+        frame.time += 1.0;
+    }
+    addRow(frame);
+}
+
+void TimelineDialog::on_removeButton_clicked()
+{
+    int row = table->currentRow();
+    if(row >= 0) {
+        table->removeRow(row);
+    }
+}
+
+void TimelineDialog::on_openButton_clicked()
+{
+    static QString dir = "/home";
+    QString fileName = QFileDialog::getOpenFileName(this, "Open File",
+        dir,
+        "JSON Files (*.json);;All Files (*)");
+
+    if(fileName.isEmpty()) {
+        return;
+    } else {
+        QFileInfo info(fileName);
+        dir = info.absolutePath();
+        Timeline timeline;
+        if(timeline.load(fileName)) {
+            setTimeline(timeline);
+        } else {
+            qWarning("%s", timeline.errorString().toLocal8Bit().constData());
+        }
+    }
+}
+
+void TimelineDialog::on_saveButton_clicked()
+{
+    static QString dir = "/home";
+    QString fileName = QFileDialog::getSaveFileName(this, "Save File",
+        dir,
+        "JSON Files (*.json);;All Files (*)");
+
+    if(fileName.isEmpty()) {
+        return;
+    } else {
+        QFileInfo info(fileName);
+        dir = info.absolutePath();
+        Timeline timeline = this->timeline();
+        if(!timeline.save(fileName)) {
+            qWarning("%s", timeline.errorString().toLocal8Bit().constData());
+        }
+    }
+}
+
+void TimelineDialog::on_logButton_clicked()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Step Log",
+        logLine->text(),
+        "CSV Files (*.csv);;All Files (*)");
+
+    if(!fileName.isEmpty()) {
+        logLine->setText(fileName);
+    }
+}
+
+void TimelineDialog::addRow(const Timeline::Keyframe& frame)
+{
+    int row = table->rowCount();
+    table->insertRow(row);
+    table->setItem(row, TimeColumn, new QTableWidgetItem(QString::number(frame.time)));
+    for(int i = 0; i < Timeline::NumValues; ++i) {
+        table->setItem(row, i + 1, new QTableWidgetItem(QString::number(frame.values[i])));
+    }
+    QTableWidgetItem* item = new QTableWidgetItem;
+    item->setFlags(Qt::ItemIsUserCheckable | Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+    item->setCheckState(frame.is_ramp ? Qt::Checked : Qt::Unchecked);
+    table->setItem(row, RampColumn, item);
+}
+
 }
@@ -0,0 +1,731 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_netem/netlink.h"
+
+#include <QFile>
+#include <QStringList>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/pkt_cls.h>
+#include <linux/pkt_sched.h>
+#include <linux/rtnetlink.h>
+#include <linux/tc_act/tc_mirred.h>
+#include <net/if.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#include <map>
+#include <vector>
+
+namespace {
+
+// the kernel keeps psched ticks of 64 ns
+const int PschedShift = 6;
+const int MaxDistribution = 16384;
+const int ReceiveLength = 8192;
+const int AckTimeout = 1;
+
+const char* distributionDirectories[] = { "/usr/lib/tc", "/usr/lib64/tc", "/lib/tc", "/usr/local/lib/tc" };
+
+struct Request {
+    quint32 sequence;
+    QString description;
+    bool is_optional;
+};
+
+qint64 nanoseconds(const double& msec)
+{
+    return (qint64)(msec * 1000000.0);
+}
+
+quint32 ticks(const qint64& nsec)
+{
+    return (quint32)qMin((qint64)0xffffffffLL, nsec >> PschedShift);
+}
+
+// percentages scale to the whole range of a u32, as with tc
+quint32 probability(const double& percent)
+{
+    if(percent >= 100.0) {
+        return 0xffffffffU;
+    }
+    return percent > 0.0 ? (quint32)(percent / 100.0 * 4294967295.0) : 0;
+}
+
+// the tables of tc, e.g. /usr/lib/tc/normal.dist
+bool loadDistribution(const QString& name, std::vector<qint16>& table)
+{
+    QStringList directories;
+    const char* directory = getenv("TC_LIB_DIR");
+    if(directory) {
+        directories << directory;
+    }
+    for(const char* path : distributionDirectories) {
+        directories << path;
+    }
+
+    for(int i = 0; i < directories.size(); ++i) {
+        QFile file(QString("%1/%2.dist").arg(directories.at(i)).arg(name));
+        if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            continue;
+        }
+        table.clear();
+        while(!file.atEnd()) {
+            QByteArray line = file.readLine().trimmed();
+            if(line.isEmpty() || line.startsWith('#')) {
+                continue;
+            }
+            QList<QByteArray> values = line.simplified().split(' ');
+            for(int j = 0; j < values.size() && (int)table.size() < MaxDistribution; ++j) {
+                table.push_back((qint16)values.at(j).toInt());
+            }
+        }
+        return !table.empty();
+    }
+    return false;
+}
+
+// a tc_u32_sel ends in a flexible array of its keys
+std::vector<char> u32Selector(const struct tc_u32_key* keys, const int& numKeys)
+{
+    std::vector<char> selector(sizeof(struct tc_u32_sel) + numKeys * sizeof(struct tc_u32_key), 0);
+    struct tc_u32_sel* sel = (struct tc_u32_sel*)selector.data();
+    sel->flags = TC_U32_TERMINAL;
+    sel->nkeys = numKeys;
+    memcpy(selector.data() + sizeof(struct tc_u32_sel), keys, numKeys * sizeof(struct tc_u32_key));
+    return selector;
+}
+
+// the message that the kernel attaches to an extended acknowledgement, if any
+QString extendedError(const struct nlmsghdr* header)
+{
+#ifdef NETLINK_EXT_ACK
+    if(!(header->nlmsg_flags & NLM_F_ACK_TLVS)) {
+        return QString();
+    }
+    const struct nlmsgerr* error = (const struct nlmsgerr*)NLMSG_DATA(header);
+    // the attributes follow the echoed request, of which only the header is left when capped
+    size_t offset = NLMSG_HDRLEN + sizeof(struct nlmsgerr);
+    if(!(header->nlmsg_flags & NLM_F_CAPPED)) {
+        offset += error->msg.nlmsg_len - NLMSG_HDRLEN;
+    }
+    if(offset > header->nlmsg_len) {
+        return QString();
+    }
+    int remaining = (int)(header->nlmsg_len - offset);
+    for(const struct rtattr* rta = (const struct rtattr*)((const char*)header + offset); RTA_OK(rta, remaining);
+            rta = RTA_NEXT(rta, remaining)) {
+        if(rta->rta_type == NLMSGERR_ATTR_MSG) {
+            const char* text = (const char*)RTA_DATA(rta);
+            return QString::fromLatin1(text, (int)strnlen(text, RTA_PAYLOAD(rta)));
+        }
+    }
+#endif
+    return QString();
+}
+
+bool parsePrefix(const QString& text, quint32& address, quint32& mask)
+{
+    QStringList list = text.split("/");
+    struct in_addr addr;
+    if(list.size() != 2 || inet_pton(AF_INET, list.at(0).toLatin1().constData(), &addr) != 1) {
+        return false;
+    }
+    bool ok = false;
+    int length = list.at(1).toInt(&ok);
+    if(!ok || length < 0 || length > 32) {
+        return false;
+    }
+    mask = length == 0 ? 0 : htonl(0xffffffffU << (32 - length));
+    address = addr.s_addr & mask;
+    return true;
+}
+
+}
+
+namespace rqt_netem {
+
+bool NetemParameters::operator==(const NetemParameters& other) const
+{
+    return limit == other.limit
+        && delay == other.delay && jitter == other.jitter && delay_correlation == other.delay_correlation
+        && delay_distribution == other.delay_distribution
+        && loss == other.loss && loss_correlation == other.loss_correlation
+        && duplicate == other.duplicate && duplicate_correlation == other.duplicate_correlation
+        && corrupt == other.corrupt && corrupt_correlation == other.corrupt_correlation
+        && reorder == other.reorder && reorder_correlation == other.reorder_correlation && gap == other.gap
+        && rate == other.rate && packet_overhead == other.packet_overhead
+        && cell_size == other.cell_size && cell_overhead == other.cell_overhead
+        && slot_min_delay == other.slot_min_delay && slot_max_delay == other.slot_max_delay
+        && slot_distribution == other.slot_distribution;
+}
+
+class Netlink::Impl
+{
+public:
+    Netlink* self;
+
+    Impl(Netlink* self);
+
+    void begin(const int& type, const int& flags, const void* header, const size_t& length,
+        const QString& description, const bool& isOptional = false);
+    void end();
+    void put(const int& type, const void* data, const size_t& length);
+    void putString(const int& type, const QString& text);
+    void putU32(const int& type, const quint32& value);
+    void append(const void* data, const size_t& length);
+    void beginNest(const int& type);
+    void endNest();
+    void beginQdisc(const int& type, const int& flags, const int& ifindex, const quint32& parent,
+        const quint32& handle, const QString& description, const bool& isOptional = false);
+    void netemQdisc(const int& flags, const int& ifindex, const quint32& parent, const quint32& handle,
+        const NetemParameters& parameters, const NetemParameters* previous, const QString& action);
+    const std::vector<qint16>* distribution(const QString& name);
+    void fail(const int& error, const QString& description);
+
+    int fd;
+    quint32 sequence;
+    std::vector<char> buffer;
+    size_t message;
+    std::vector<size_t> nests;
+    std::vector<Request> requests;
+    int pending_error;
+    QString error_string;
+    std::map<QString, std::vector<qint16>> distributions;
+};
+
+
+Netlink::Netlink()
+{
+    impl = new Impl(this);
+}
+
+Netlink::Impl::Impl(Netlink* self)
+    : self(self)
+{
+    fd = -1;
+    sequence = 0;
+    message = 0;
+    pending_error = 0;
+}
+
+Netlink::~Netlink()
+{
+    close();
+    delete impl;
+}
+
+int Netlink::open()
+{
+    close();
+    impl->fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if(impl->fd < 0) {
+        int error = errno;
+        impl->error_string = QString("socket: %1").arg(strerror(error));
+        return -error;
+    }
+
+    // the acknowledgements are awaited in the GUI thread, a kernel that never answers
+    // must not hang it
+    struct timeval timeout = { AckTimeout, 0 };
+    setsockopt(impl->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // an error would echo the whole request, a distribution table makes that 32 KB, only the
+    // header of it is wanted; the extended acknowledgements carry the reason of the kernel.
+    // Older kernels have neither, commit() takes replies of any length anyway
+    int on = 1;
+    setsockopt(impl->fd, SOL_NETLINK, NETLINK_CAP_ACK, &on, sizeof(on));
+#ifdef NETLINK_EXT_ACK
+    setsockopt(impl->fd, SOL_NETLINK, NETLINK_EXT_ACK, &on, sizeof(on));
+#endif
+
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    if(bind(impl->fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        int error = errno;
+        impl->error_string = QString("bind: %1").arg(strerror(error));
+        close();
+        return -error;
+    }
+    impl->sequence = (quint32)time(nullptr);
+    return 0;
+}
+
+void Netlink::close()
+{
+    if(impl->fd >= 0) {
+        ::close(impl->fd);
+        impl->fd = -1;
+    }
+    impl->buffer.clear();
+    impl->requests.clear();
+    impl->pending_error = 0;
+}
+
+bool Netlink::isOpen() const
+{
+    return impl->fd >= 0;
+}
+
+void Netlink::addLink(const QString& name, const QString& kind)
+{
+    struct ifinfomsg info;
+    memset(&info, 0, sizeof(info));
+    info.ifi_family = AF_UNSPEC;
+    impl->begin(RTM_NEWLINK, NLM_F_CREATE | NLM_F_EXCL, &info, sizeof(info), QString("add link %1").arg(name));
+    impl->putString(IFLA_IFNAME, name);
+    impl->beginNest(IFLA_LINKINFO);
+    impl->putString(IFLA_INFO_KIND, kind);
+    impl->endNest();
+    impl->end();
+}
+
+void Netlink::deleteLink(const int& ifindex)
+{
+    struct ifinfomsg info;
+    memset(&info, 0, sizeof(info));
+    info.ifi_family = AF_UNSPEC;
+    info.ifi_index = ifindex;
+    impl->begin(RTM_DELLINK, 0, &info, sizeof(info), QString("delete link %1").arg(ifindex));
+    impl->end();
+}
+
+void Netlink::setLinkUp(const int& ifindex, const bool& up)
+{
+    struct ifinfomsg info;
+    memset(&info, 0, sizeof(info));
+    info.ifi_family = AF_UNSPEC;
+    info.ifi_index = ifindex;
+    info.ifi_flags = up ? IFF_UP : 0;
+    info.ifi_change = IFF_UP;
+    impl->begin(RTM_NEWLINK, 0, &info, sizeof(info), QString("set link %1 %2").arg(ifindex).arg(up ? "up" : "down"));
+    impl->end();
+}
+
+void Netlink::addIngressQdisc(const int& ifindex)
+{
+    impl->beginQdisc(RTM_NEWQDISC, NLM_F_CREATE | NLM_F_EXCL, ifindex, TC_H_INGRESS, TC_H_MAKE(TC_H_INGRESS, 0),
+        QString("add ingress qdisc on %1").arg(ifindex));
+    impl->putString(TCA_KIND, "ingress");
+    impl->end();
+}
+
+void Netlink::addPrioQdisc(const int& ifindex, const quint32& handle, const int& bands)
+{
+    // every priority maps to the first band, the filters pick the others
+    struct tc_prio_qopt opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.bands = bands;
+    impl->beginQdisc(RTM_NEWQDISC, NLM_F_CREATE | NLM_F_EXCL, ifindex, TC_H_ROOT, handle,
+        QString("add prio qdisc on %1").arg(ifindex));
+    impl->putString(TCA_KIND, "prio");
+    impl->put(TCA_OPTIONS, &opt, sizeof(opt));
+    impl->end();
+}
+
+void Netlink::addNetemQdisc(const int& ifindex, const quint32& parent, const quint32& handle,
+    const NetemParameters& parameters)
+{
+    impl->netemQdisc(NLM_F_CREATE | NLM_F_EXCL, ifindex, parent, handle, parameters, nullptr, "add");
+}
+
+void Netlink::changeNetemQdisc(const int& ifindex, const quint32& parent, const quint32& handle,
+    const NetemParameters& parameters, const NetemParameters& previous)
+{
+    impl->netemQdisc(0, ifindex, parent, handle, parameters, &previous, "change");
+}
+
+void Netlink::deleteRootQdisc(const int& ifindex)
+{
+    impl->beginQdisc(RTM_DELQDISC, 0, ifindex, TC_H_ROOT, 0, QString("delete root qdisc on %1").arg(ifindex), true);
+    impl->end();
+}
+
+void Netlink::deleteIngressQdisc(const int& ifindex)
+{
+    impl->beginQdisc(RTM_DELQDISC, 0, ifindex, TC_H_INGRESS, TC_H_MAKE(TC_H_INGRESS, 0),
+        QString("delete ingress qdisc on %1").arg(ifindex), true);
+    impl->end();
+}
+
+void Netlink::addRedirectFilter(const int& ifindex, const int& target)
+{
+    struct tc_u32_key key;
+    memset(&key, 0, sizeof(key));
+    std::vector<char> selector = u32Selector(&key, 1);
+
+    struct tc_mirred mirred;
+    memset(&mirred, 0, sizeof(mirred));
+    mirred.action = TC_ACT_STOLEN;
+    mirred.eaction = TCA_EGRESS_REDIR;
+    mirred.ifindex = target;
+
+    impl->beginQdisc(RTM_NEWTFILTER, NLM_F_CREATE | NLM_F_EXCL, ifindex, TC_H_MAKE(TC_H_INGRESS, 0), 0,
+        QString("add redirect filter on %1").arg(ifindex));
+    struct tcmsg* tcm = (struct tcmsg*)NLMSG_DATA(&impl->buffer[impl->message]);
+    tcm->tcm_info = TC_H_MAKE(0, htons(ETH_P_IP));
+    impl->putString(TCA_KIND, "u32");
+    impl->beginNest(TCA_OPTIONS);
+    impl->beginNest(TCA_U32_ACT);
+    impl->beginNest(1);
+    impl->putString(TCA_ACT_KIND, "mirred");
+    impl->beginNest(TCA_ACT_OPTIONS);
+    impl->put(TCA_MIRRED_PARMS, &mirred, sizeof(mirred));
+    impl->endNest();
+    impl->endNest();
+    impl->endNest();
+    impl->put(TCA_U32_SEL, selector.data(), selector.size());
+    impl->endNest();
+    impl->end();
+}
+
+void Netlink::addFlowFilter(const int& ifindex, const quint32& parent, const int& priority,
+    const QString& source, const QString& destination, const quint32& flowid)
+{
+    QString description = QString("add filter %1 %2 on %3").arg(source).arg(destination).arg(ifindex);
+    quint32 source_address, source_mask, destination_address, destination_mask;
+    if(!parsePrefix(source, source_address, source_mask)
+            || !parsePrefix(destination, destination_address, destination_mask)) {
+        impl->fail(-EINVAL, QString("%1: invalid prefix").arg(description));
+        return;
+    }
+
+    // "match ip src" and "match ip dst" are the words at offsets 12 and 16 of the IPv4 header
+    struct tc_u32_key keys[2];
+    memset(keys, 0, sizeof(keys));
+    keys[0].mask = source_mask;
+    keys[0].val = source_address;
+    keys[0].off = 12;
+    keys[1].mask = destination_mask;
+    keys[1].val = destination_address;
+    keys[1].off = 16;
+    std::vector<char> selector = u32Selector(keys, 2);
+
+    impl->beginQdisc(RTM_NEWTFILTER, NLM_F_CREATE | NLM_F_EXCL, ifindex, parent, 0, description);
+    struct tcmsg* tcm = (struct tcmsg*)NLMSG_DATA(&impl->buffer[impl->message]);
+    tcm->tcm_info = TC_H_MAKE((quint32)priority << 16, htons(ETH_P_IP));
+    impl->putString(TCA_KIND, "u32");
+    impl->beginNest(TCA_OPTIONS);
+    impl->putU32(TCA_U32_CLASSID, flowid);
+    impl->put(TCA_U32_SEL, selector.data(), selector.size());
+    impl->endNest();
+    impl->end();
+}
+
+void Netlink::deleteFlowFilters(const int& ifindex, const quint32& parent, const int& priority)
+{
+    impl->beginQdisc(RTM_DELTFILTER, 0, ifindex, parent, 0,
+        QString("delete filters of priority %1 on %2").arg(priority).arg(ifindex), true);
+    struct tcmsg* tcm = (struct tcmsg*)NLMSG_DATA(&impl->buffer[impl->message]);
+    tcm->tcm_info = TC_H_MAKE((quint32)priority << 16, htons(ETH_P_IP));
+    impl->end();
+}
+
+int Netlink::commit()
+{
+    int ret = impl->pending_error;
+    if(ret == 0 && impl->requests.empty()) {
+        return 0;
+    }
+    if(ret == 0 && impl->fd < 0) {
+        ret = -EBADF;
+        impl->error_string = "netlink: not open";
+    }
+
+    if(ret == 0) {
+        // every message of the batch goes out with a single sendmsg
+        struct sockaddr_nl addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.nl_family = AF_NETLINK;
+        struct iovec iov = { impl->buffer.data(), impl->buffer.size() };
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &addr;
+        msg.msg_namelen = sizeof(addr);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        if(sendmsg(impl->fd, &msg, 0) < 0) {
+            ret = -errno;
+            impl->error_string = QString("netlink: sendmsg: %1").arg(strerror(errno));
+        }
+    }
+
+    // the kernel answers every request in order, also after one of them failed
+    quint32 first = impl->requests.empty() ? 0 : impl->requests.front().sequence;
+    size_t num_acks = 0;
+    std::vector<char> reply(ReceiveLength);
+    while(ret == 0 && num_acks < impl->requests.size()) {
+        // a reply that does not fit would be cut off and its acknowledgement lost
+        ssize_t length = recv(impl->fd, reply.data(), reply.size(), MSG_PEEK | MSG_TRUNC);
+        if(length > (ssize_t)reply.size()) {
+            reply.resize(length);
+        }
+        if(length >= 0) {
+            length = recv(impl->fd, reply.data(), reply.size(), 0);
+        }
+        if(length < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            ret = -errno;
+            impl->error_string = QString("netlink: recv: %1").arg(strerror(errno));
+            break;
+        }
+        int remaining = (int)length;
+        for(struct nlmsghdr* header = (struct nlmsghdr*)reply.data(); NLMSG_OK(header, remaining);
+                header = NLMSG_NEXT(header, remaining)) {
+            if(header->nlmsg_type != NLMSG_ERROR) {
+                continue;
+            }
+            size_t index = header->nlmsg_seq - first;
+            if(index >= impl->requests.size()) {
+                continue;
+            }
+            ++num_acks;
+            const struct nlmsgerr* error = (const struct nlmsgerr*)NLMSG_DATA(header);
+            const Request& request = impl->requests[index];
+            if(error->error != 0 && !request.is_optional && ret == 0) {
+                ret = error->error;
+                impl->error_string = QString("%1: %2").arg(request.description).arg(strerror(-error->error));
+                QString reason = extendedError(header);
+                if(!reason.isEmpty()) {
+                    impl->error_string += QString(" (%1)").arg(reason);
+                }
+            }
+        }
+    }
+
+    impl->buffer.clear();
+    impl->requests.clear();
+    impl->nests.clear();
+    impl->pending_error = 0;
+    return ret;
+}
+
+QString Netlink::errorString() const
+{
+    return impl->error_string;
+}
+
+int Netlink::interfaceIndex(const QString& name)
+{
+    return (int)if_nametoindex(name.toLocal8Bit().constData());
+}
+
+void Netlink::Impl::begin(const int& type, const int& flags, const void* header, const size_t& length,
+    const QString& description, const bool& isOptional)
+{
+    message = buffer.size();
+    struct nlmsghdr nlh;
+    memset(&nlh, 0, sizeof(nlh));
+    nlh.nlmsg_type = type;
+    nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | flags;
+    nlh.nlmsg_seq = ++sequence;
+    append(&nlh, sizeof(nlh));
+    append(header, length);
+
+    Request request = { sequence, description, isOptional };
+    requests.push_back(request);
+}
+
+void Netlink::Impl::end()
+{
+    struct nlmsghdr* nlh = (struct nlmsghdr*)&buffer[message];
+    nlh->nlmsg_len = buffer.size() - message;
+}
+
+void Netlink::Impl::put(const int& type, const void* data, const size_t& length)
+{
+    struct rtattr rta;
+    rta.rta_type = type;
+    rta.rta_len = RTA_LENGTH(length);
+    append(&rta, sizeof(rta));
+    append(data, length);
+}
+
+void Netlink::Impl::putString(const int& type, const QString& text)
+{
+    QByteArray data = text.toLatin1();
+    put(type, data.constData(), data.size() + 1);
+}
+
+void Netlink::Impl::putU32(const int& type, const quint32& value)
+{
+    put(type, &value, sizeof(value));
+}
+
+void Netlink::Impl::append(const void* data, const size_t& length)
+{
+    // the attributes start on four byte boundaries, the padding is zero
+    size_t position = buffer.size();
+    buffer.resize(position + RTA_ALIGN(length), 0);
+    if(length > 0) {
+        memcpy(&buffer[position], data, length);
+    }
+}
+
+void Netlink::Impl::beginNest(const int& type)
+{
+    nests.push_back(buffer.size());
+    put(type, nullptr, 0);
+}
+
+void Netlink::Impl::endNest()
+{
+    size_t position = nests.back();
+    nests.pop_back();
+    struct rtattr* rta = (struct rtattr*)&buffer[position];
+    rta->rta_len = buffer.size() - position;
+}
+
+void Netlink::Impl::beginQdisc(const int& type, const int& flags, const int& ifindex, const quint32& parent,
+    const quint32& handle, const QString& description, const bool& isOptional)
+{
+    struct tcmsg tcm;
+    memset(&tcm, 0, sizeof(tcm));
+    tcm.tcm_family = AF_UNSPEC;
+    tcm.tcm_ifindex = ifindex;
+    tcm.tcm_parent = parent;
+    tcm.tcm_handle = handle;
+    begin(type, flags, &tcm, sizeof(tcm), description, isOptional);
+}
+
+void Netlink::Impl::netemQdisc(const int& flags, const int& ifindex, const quint32& parent, const quint32& handle,
+    const NetemParameters& parameters, const NetemParameters* previous, const QString& action)
+{
+    QString description = QString("%1 netem qdisc %2: on %3").arg(action).arg(handle >> 16, 0, 16).arg(ifindex);
+    qint64 latency = nanoseconds(parameters.delay);
+    qint64 jitter = nanoseconds(parameters.jitter);
+
+    const std::vector<qint16>* delay_table = nullptr;
+    if(!parameters.delay_distribution.isEmpty()) {
+        delay_table = distribution(parameters.delay_distribution);
+        if(!delay_table) {
+            fail(-ENOENT, QString("%1: no distribution data for %2").arg(description).arg(parameters.delay_distribution));
+            return;
+        }
+    }
+    const std::vector<qint16>* slot_table = nullptr;
+    if(!parameters.slot_distribution.isEmpty()) {
+        slot_table = distribution(parameters.slot_distribution);
+        if(!slot_table) {
+            fail(-ENOENT, QString("%1: no distribution data for %2").arg(description).arg(parameters.slot_distribution));
+            return;
+        }
+    }
+    if(parameters.reorder > 0.0 && latency == 0) {
+        fail(-EINVAL, QString("%1: reordering not possible without a delay").arg(description));
+        return;
+    }
+
+    struct tc_netem_qopt opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.limit = parameters.limit;
+    opt.latency = ticks(latency);
+    opt.jitter = ticks(jitter);
+    opt.loss = probability(parameters.loss);
+    opt.duplicate = probability(parameters.duplicate);
+    opt.gap = parameters.gap;
+    if(parameters.reorder > 0.0 && opt.gap == 0) {
+        // tc reorders every other packet unless a gap is given
+        opt.gap = 1;
+    }
+
+    beginQdisc(RTM_NEWQDISC, flags, ifindex, parent, handle, description);
+    putString(TCA_KIND, "netem");
+
+    // the options of netem are a struct followed by attributes, not a nest
+    beginNest(TCA_OPTIONS);
+    append(&opt, sizeof(opt));
+    if(latency > 0) {
+        put(TCA_NETEM_LATENCY64, &latency, sizeof(latency));
+    }
+    if(jitter > 0) {
+        put(TCA_NETEM_JITTER64, &jitter, sizeof(jitter));
+    }
+
+    // a change keeps whatever it leaves out, so the zeros go out as well
+    struct tc_netem_corr corr;
+    corr.delay_corr = probability(parameters.delay_correlation);
+    corr.loss_corr = probability(parameters.loss_correlation);
+    corr.dup_corr = probability(parameters.duplicate_correlation);
+    put(TCA_NETEM_CORR, &corr, sizeof(corr));
+
+    struct tc_netem_reorder reorder;
+    reorder.probability = probability(parameters.reorder);
+    reorder.correlation = probability(parameters.reorder_correlation);
+    put(TCA_NETEM_REORDER, &reorder, sizeof(reorder));
+
+    struct tc_netem_corrupt corrupt;
+    corrupt.probability = probability(parameters.corrupt);
+    corrupt.correlation = probability(parameters.corrupt_correlation);
+    put(TCA_NETEM_CORRUPT, &corrupt, sizeof(corrupt));
+
+    struct tc_netem_rate rate;
+    quint64 rate64 = parameters.rate > 0.0 ? (quint64)parameters.rate : 0;
+    rate.rate = rate64 >= 0xffffffffULL ? 0xffffffffU : (quint32)rate64;
+    rate.packet_overhead = parameters.packet_overhead;
+    rate.cell_size = parameters.cell_size;
+    rate.cell_overhead = parameters.cell_overhead;
+    put(TCA_NETEM_RATE, &rate, sizeof(rate));
+    if(rate64 >= 0xffffffffULL) {
+        put(TCA_NETEM_RATE64, &rate64, sizeof(rate64));
+    }
+
+    // all zero turns the slots off
+    struct tc_netem_slot slot;
+    memset(&slot, 0, sizeof(slot));
+    if(slot_table) {
+        slot.dist_delay = nanoseconds(parameters.slot_min_delay);
+        slot.dist_jitter = nanoseconds(parameters.slot_max_delay);
+    } else if(parameters.slot_min_delay > 0.0) {
+        slot.min_delay = nanoseconds(parameters.slot_min_delay);
+        slot.max_delay = nanoseconds(qMax(parameters.slot_min_delay, parameters.slot_max_delay));
+    }
+    put(TCA_NETEM_SLOT, &slot, sizeof(slot));
+
+    // a table is 32 KB, a change leaves it out when the qdisc has it already
+    if(delay_table && !(previous && previous->delay_distribution == parameters.delay_distribution)) {
+        put(TCA_NETEM_DELAY_DIST, delay_table->data(), delay_table->size() * sizeof(qint16));
+    }
+    if(slot_table && !(previous && previous->slot_distribution == parameters.slot_distribution)) {
+        put(TCA_NETEM_SLOT_DIST, slot_table->data(), slot_table->size() * sizeof(qint16));
+    }
+    endNest();
+    end();
+}
+
+const std::vector<qint16>* Netlink::Impl::distribution(const QString& name)
+{
+    // the files are read once, a table that is missing is looked for again next time
+    auto it = distributions.find(name);
+    if(it == distributions.end()) {
+        std::vector<qint16> table;
+        if(!loadDistribution(name, table)) {
+            return nullptr;
+        }
+        it = distributions.insert(std::make_pair(name, table)).first;
+    }
+    return &it->second;
+}
+
+void Netlink::Impl::fail(const int& error, const QString& description)
+{
+    // the request is dropped and commit() reports it unless an earlier one failed
+    if(pending_error == 0) {
+        pending_error = error;
+        error_string = description;
+    }
+}
+
+}
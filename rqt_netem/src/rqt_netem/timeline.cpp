@@ -0,0 +1,151 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_netem/timeline.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+
+namespace {
+
+struct ValueInfo {
+    const char* key;
+    const char* label;
+};
+
+ValueInfo valueInfo[] = {
+    { "inbound_delay",   "Inbound Delay [ms]" },   { "outbound_delay",   "Outbound Delay [ms]" },
+    { "inbound_loss",    "Inbound Loss [%]" },     { "outbound_loss",    "Outbound Loss [%]" },
+    { "inbound_rate",    "Inbound Rate [kB/s]" },  { "outbound_rate",    "Outbound Rate [kB/s]" },
+    { "inbound_jitter",  "Inbound Jitter [ms]" },  { "outbound_jitter",  "Outbound Jitter [ms]" }
+};
+
+bool earlier(const rqt_netem::Timeline::Keyframe& a, const rqt_netem::Timeline::Keyframe& b)
+{
+    return a.time < b.time;
+}
+
+}
+
+namespace rqt_netem {
+
+Timeline::Timeline()
+{
+
+}
+
+void Timeline::clear()
+{
+    frames.clear();
+}
+
+void Timeline::setKeyframes(const std::vector<Keyframe>& keyframes)
+{
+    frames = keyframes;
+    std::stable_sort(frames.begin(), frames.end(), earlier);
+}
+
+double Timeline::duration() const
+{
+    return frames.empty() ? 0.0 : frames.back().time;
+}
+
+void Timeline::valuesAt(const double& time, double* values) const
+{
+    if(frames.empty()) {
+        std::fill(values, values + NumValues, 0.0);
+        return;
+    }
+
+    Keyframe key;
+    key.time = time;
+    auto next = std::upper_bound(frames.begin(), frames.end(), key, earlier);
+    if(next == frames.begin()) {
+        std::copy(next->values, next->values + NumValues, values);
+        return;
+    }
+    const Keyframe& frame = *(next - 1);
+    if(next == frames.end() || !frame.is_ramp || next->time <= frame.time) {
+        std::copy(frame.values, frame.values + NumValues, values);
+        return;
+    }
+
+    double ratio = (time - frame.time) / (next->time - frame.time);
+    for(int i = 0; i < NumValues; ++i) {
+        values[i] = frame.values[i] + (next->values[i] - frame.values[i]) * ratio;
+    }
+}
+
+bool Timeline::load(const QString& fileName)
+{
+    QFile loadFile(fileName);
+    if(!loadFile.open(QIODevice::ReadOnly)) {
+        error_string = QString("%1: %2").arg(fileName).arg(loadFile.errorString());
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(loadFile.readAll(), &error);
+    if(document.isNull() || !document.object()["keyframes"].isArray()) {
+        error_string = QString("%1: not a keyframe file (%2)").arg(fileName).arg(error.errorString());
+        return false;
+    }
+
+    std::vector<Keyframe> keyframes;
+    const QJsonArray array = document.object()["keyframes"].toArray();
+    for(int i = 0; i < array.size(); ++i) {
+        const QJsonObject object = array[i].toObject();
+        Keyframe frame;
+        frame.time = object["time"].toDouble();
+        for(int j = 0; j < NumValues; ++j) {
+            frame.values[j] = object[valueKey(j)].toDouble();
+        }
+        frame.is_ramp = object["interpolation"].toString("linear") != "step";
+        keyframes.push_back(frame);
+    }
+    setKeyframes(keyframes);
+    return true;
+}
+
+bool Timeline::save(const QString& fileName) const
+{
+    QFile saveFile(fileName);
+    if(!saveFile.open(QIODevice::WriteOnly)) {
+        error_string = QString("%1: %2").arg(fileName).arg(saveFile.errorString());
+        return false;
+    }
+
+    QJsonArray array;
+    for(size_t i = 0; i < frames.size(); ++i) {
+        const Keyframe& frame = frames[i];
+        QJsonObject object;
+        object["time"] = frame.time;
+        for(int j = 0; j < NumValues; ++j) {
+            object[valueKey(j)] = frame.values[j];
+        }
+        object["interpolation"] = frame.is_ramp ? "linear" : "step";
+        array.append(object);
+    }
+
+    QJsonObject object;
+    object["keyframes"] = array;
+    saveFile.write(QJsonDocument(object).toJson());
+    return true;
+}
+
+QString Timeline::valueKey(const int& value)
+{
+    return valueInfo[value].key;
+}
+
+QString Timeline::valueLabel(const int& value)
+{
+    return valueInfo[value].label;
+}
+
+}
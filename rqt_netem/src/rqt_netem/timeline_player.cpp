@@ -0,0 +1,269 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_netem/timeline_player.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
+
+namespace {
+
+const double MinRate = 1.0;
+const double MaxRate = 100.0;
+
+}
+
+namespace rqt_netem {
+
+class TimelinePlayer::Impl
+{
+public:
+    TimelinePlayer* self;
+
+    Impl(TimelinePlayer* self);
+
+    void start();
+    void stop();
+    void step();
+    void schedule();
+    void log(const qint64& index, const qint64& due, const qint64& begin, const qint64& end, const double* values);
+
+    qint64 period() const { return (qint64)(1000000000.0 / rate); }
+
+    ApplyFunction applyFunction;
+    SourceFunction sourceFunction;
+    double rate;
+    QString log_file_name;
+    QFile log_file;
+    QTimer timer;
+    QElapsedTimer clock;
+    qint64 next_step;
+    bool is_playing;
+
+    int num_steps;
+    int num_skipped_steps;
+    double sum_lateness;
+    double max_lateness;
+};
+
+
+TimelinePlayer::TimelinePlayer(QObject* parent)
+    : QObject(parent)
+{
+    impl = new Impl(this);
+}
+
+TimelinePlayer::Impl::Impl(TimelinePlayer* self)
+    : self(self)
+{
+    rate = 10.0;
+    next_step = 0;
+    is_playing = false;
+    num_steps = 0;
+    num_skipped_steps = 0;
+    sum_lateness = 0.0;
+    max_lateness = 0.0;
+
+    // the coarse timers of Qt may fire 5% of the interval late
+    timer.setTimerType(Qt::PreciseTimer);
+    timer.setSingleShot(true);
+    self->connect(&timer, &QTimer::timeout, [&](){ step(); });
+}
+
+TimelinePlayer::~TimelinePlayer()
+{
+    impl->stop();
+    delete impl;
+}
+
+void TimelinePlayer::setApplyFunction(const ApplyFunction& function)
+{
+    impl->applyFunction = function;
+}
+
+void TimelinePlayer::setSourceFunction(const SourceFunction& function)
+{
+    impl->sourceFunction = function;
+}
+
+void TimelinePlayer::setTimeline(const Timeline& timeline)
+{
+    impl->sourceFunction = [timeline](const double& time, double* values){
+        timeline.valuesAt(time, values);
+        return time < timeline.duration();
+    };
+}
+
+void TimelinePlayer::setRate(const double& rate)
+{
+    impl->rate = qBound(MinRate, rate, MaxRate);
+}
+
+double TimelinePlayer::rate() const
+{
+    return impl->rate;
+}
+
+void TimelinePlayer::setLogFile(const QString& fileName)
+{
+    impl->log_file_name = fileName;
+}
+
+void TimelinePlayer::start()
+{
+    impl->start();
+}
+
+void TimelinePlayer::Impl::start()
+{
+    stop();
+    if(!sourceFunction) {
+        return;
+    }
+
+    num_steps = 0;
+    num_skipped_steps = 0;
+    sum_lateness = 0.0;
+    max_lateness = 0.0;
+
+    if(!log_file_name.isEmpty()) {
+        log_file.setFileName(log_file_name);
+        if(log_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            QByteArray header = "step,scheduled_ms,begin_ms,applied_ms,lateness_ms";
+            for(int i = 0; i < Timeline::NumValues; ++i) {
+                header += ",";
+                header += Timeline::valueKey(i).toLatin1();
+            }
+            header += "\n";
+            log_file.write(header);
+        } else {
+            emit self->errored(QString("%1: %2").arg(log_file_name).arg(log_file.errorString()));
+        }
+    }
+
+    is_playing = true;
+    next_step = 0;
+    clock.start();
+    step();
+}
+
+void TimelinePlayer::stop()
+{
+    impl->stop();
+}
+
+void TimelinePlayer::Impl::stop()
+{
+    timer.stop();
+    is_playing = false;
+    if(log_file.isOpen()) {
+        log_file.close();
+    }
+}
+
+bool TimelinePlayer::isPlaying() const
+{
+    return impl->is_playing;
+}
+
+int TimelinePlayer::numSteps() const
+{
+    return impl->num_steps;
+}
+
+int TimelinePlayer::numSkippedSteps() const
+{
+    return impl->num_skipped_steps;
+}
+
+double TimelinePlayer::meanLateness() const
+{
+    return impl->num_steps > 0 ? impl->sum_lateness / impl->num_steps : 0.0;
+}
+
+double TimelinePlayer::maxLateness() const
+{
+    return impl->max_lateness;
+}
+
+void TimelinePlayer::Impl::step()
+{
+    if(!is_playing) {
+        return;
+    }
+
+    qint64 now = clock.nsecsElapsed();
+    qint64 index = next_step;
+    if(now < index * period()) {
+        schedule();
+        return;
+    }
+
+    // a step that is overtaken by the next one is not applied any more
+    qint64 latest = now / period();
+    if(latest > index) {
+        num_skipped_steps += (int)(latest - index);
+        index = latest;
+    }
+
+    qint64 due = index * period();
+    double values[Timeline::NumValues] = {};
+    bool is_last = !sourceFunction((double)due / 1000000000.0, values);
+    qint64 begin = clock.nsecsElapsed();
+    if(applyFunction) {
+        applyFunction(values);
+    }
+    qint64 end = clock.nsecsElapsed();
+
+    double lateness = (double)(end - due) / 1000000.0;
+    ++num_steps;
+    sum_lateness += lateness;
+    max_lateness = qMax(max_lateness, lateness);
+    log(index, due, begin, end, values);
+
+    emit self->stepped((double)due / 1000000000.0);
+
+    next_step = index + 1;
+    if(is_last) {
+        stop();
+        emit self->finished();
+    } else {
+        schedule();
+    }
+}
+
+void TimelinePlayer::Impl::schedule()
+{
+    // the timer has millisecond resolution: it is armed for the whole milliseconds to the step,
+    // the remainder is waited out with zero timeouts, which return to the event loop in between
+    qint64 wait = next_step * period() - clock.nsecsElapsed();
+    timer.start(wait > 0 ? (int)(wait / 1000000) : 0);
+}
+
+void TimelinePlayer::Impl::log(const qint64& index, const qint64& due, const qint64& begin, const qint64& end,
+    const double* values)
+{
+    if(!log_file.isOpen()) {
+        return;
+    }
+
+    QByteArray line = QByteArray::number(index);
+    line += ",";
+    line += QByteArray::number((double)due / 1000000.0, 'f', 3);
+    line += ",";
+    line += QByteArray::number((double)begin / 1000000.0, 'f', 3);
+    line += ",";
+    line += QByteArray::number((double)end / 1000000.0, 'f', 3);
+    line += ",";
+    line += QByteArray::number((double)(end - due) / 1000000.0, 'f', 3);
+    for(int i = 0; i < Timeline::NumValues; ++i) {
+        line += ",";
+        line += QByteArray::number(values[i], 'g', 6);
+    }
+    line += "\n";
+    log_file.write(line);
+}
+
+}
@@ -0,0 +1,221 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_netem/trace_reader.h"
+
+#include <QList>
+
+namespace {
+
+struct SharedInfo {
+    const char* name;
+    int inbound;
+    int outbound;
+};
+
+SharedInfo sharedInfo[] = {
+    { "delay",  rqt_netem::Timeline::InboundDelay,  rqt_netem::Timeline::OutboundDelay },
+    { "jitter", rqt_netem::Timeline::InboundJitter, rqt_netem::Timeline::OutboundJitter },
+    { "loss",   rqt_netem::Timeline::InboundLoss,   rqt_netem::Timeline::OutboundLoss },
+    { "rate",   rqt_netem::Timeline::InboundRate,   rqt_netem::Timeline::OutboundRate }
+};
+
+// the rates of a trace are in kbit/s, those of the timeline in the kbps of tc, i.e. kB/s
+double fromTrace(const int& value, const double& number)
+{
+    if(value == rqt_netem::Timeline::InboundRate || value == rqt_netem::Timeline::OutboundRate) {
+        return number / 8.0;
+    }
+    return number;
+}
+
+QList<QByteArray> splitLine(const QByteArray& line, const char& separator)
+{
+    if(separator == ' ') {
+        return line.simplified().split(' ');
+    }
+    return line.split(separator);
+}
+
+}
+
+namespace rqt_netem {
+
+TraceReader::TraceReader()
+{
+    separator = ',';
+    has_next = false;
+    first_time = 0.0;
+    interval = 0.0;
+    last_time = 0.0;
+    num_rows = 0;
+    num_skipped_lines = 0;
+}
+
+TraceReader::~TraceReader()
+{
+    close();
+}
+
+bool TraceReader::open(const QString& fileName)
+{
+    close();
+
+    file.setFileName(fileName);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error_string = QString("%1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+
+    QByteArray header;
+    while(!file.atEnd() && header.isEmpty()) {
+        header = file.readLine().trimmed();
+        if(header.startsWith('#')) {
+            header.clear();
+        }
+    }
+    separator = header.contains(',') ? ',' : (header.contains(';') ? ';' : ' ');
+
+    // the columns that are not known are ignored
+    bool has_time = false;
+    QList<QByteArray> names = splitLine(header, separator);
+    for(int i = 0; i < names.size(); ++i) {
+        QString name = QString::fromLatin1(names.at(i).trimmed()).toLower();
+        int column = Unused;
+        int shared = Unused;
+        if(name == "time" || name == "t" || name == "timestamp") {
+            column = TimeColumn;
+            has_time = true;
+        }
+        for(int j = 0; j < Timeline::NumValues; ++j) {
+            if(name == Timeline::valueKey(j)) {
+                column = j;
+            }
+        }
+        for(const SharedInfo& info : sharedInfo) {
+            if(name == info.name) {
+                column = info.inbound;
+                shared = info.outbound;
+            }
+        }
+        columns.push_back(column);
+        shared_columns.push_back(shared);
+    }
+    if(!has_time) {
+        error_string = QString("%1: no time column in the header").arg(fileName);
+        close();
+        return false;
+    }
+
+    // the times are replayed from the first row on, whether they are relative or from the epoch
+    std::fill(current.values, current.values + Timeline::NumValues, 0.0);
+    current.time = -1.0e300;
+    if(!readRow(current)) {
+        error_string = QString("%1: no rows").arg(fileName);
+        close();
+        return false;
+    }
+    first_time = current.time;
+    current.time = 0.0;
+
+    next = current;
+    has_next = readRow(next);
+    interval = has_next ? next.time : 0.0;
+    last_time = 0.0;
+    return true;
+}
+
+void TraceReader::close()
+{
+    if(file.isOpen()) {
+        file.close();
+    }
+    columns.clear();
+    shared_columns.clear();
+    has_next = false;
+    first_time = 0.0;
+    interval = 0.0;
+    last_time = 0.0;
+    num_rows = 0;
+    num_skipped_lines = 0;
+}
+
+bool TraceReader::valuesAt(const double& time, double* values)
+{
+    if(!file.isOpen()) {
+        return false;
+    }
+
+    double from = last_time;
+    double to = qMax(time, last_time);
+    double sums[Timeline::NumValues] = {};
+    double weight = 0.0;
+    auto add = [&](const Row& row, const double& span) {
+        if(span > 0.0) {
+            for(int i = 0; i < Timeline::NumValues; ++i) {
+                sums[i] += row.values[i] * span;
+            }
+            weight += span;
+        }
+    };
+
+    while(has_next && next.time <= to) {
+        add(current, next.time - qMax(current.time, from));
+        // the last row is taken to last as long as the one before it
+        interval = next.time - current.time;
+        current = next;
+        has_next = readRow(next);
+    }
+    add(current, to - qMax(current.time, from));
+
+    for(int i = 0; i < Timeline::NumValues; ++i) {
+        values[i] = weight > 0.0 ? sums[i] / weight : current.values[i];
+    }
+    last_time = to;
+    return has_next || to < current.time + interval;
+}
+
+bool TraceReader::readRow(Row& row)
+{
+    // the row starts as a copy of the one before, a field that is empty keeps its value
+    double previous = row.time;
+    while(!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        if(line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+
+        QList<QByteArray> fields = splitLine(line, separator);
+        Row candidate = row;
+        bool has_time = false;
+        for(int i = 0; i < fields.size() && i < (int)columns.size(); ++i) {
+            bool ok = false;
+            double value = fields.at(i).trimmed().toDouble(&ok);
+            if(!ok || columns[i] == Unused) {
+                continue;
+            }
+            if(columns[i] == TimeColumn) {
+                candidate.time = value - first_time;
+                has_time = true;
+            } else {
+                candidate.values[columns[i]] = fromTrace(columns[i], value);
+                if(shared_columns[i] != Unused) {
+                    candidate.values[shared_columns[i]] = fromTrace(shared_columns[i], value);
+                }
+            }
+        }
+
+        // a row without a time or one that goes back in time cannot be replayed
+        if(!has_time || candidate.time < previous) {
+            ++num_skipped_lines;
+            continue;
+        }
+        row = candidate;
+        ++num_rows;
+        return true;
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,49 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__load_generator_H
+#define rqt_ping__load_generator_H
+
+#include <QString>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace rqt_ping {
+
+class SocketSet;
+
+class LoadGenerator
+{
+public:
+    LoadGenerator(SocketSet* sockets);
+    ~LoadGenerator();
+
+    enum Protocol { Tcp, Udp };
+
+    // UDP flows are paced, TCP flows send as fast as the congestion window allows
+    void setUdpRate(const double& mbps);
+    double udpRate() const;
+
+    // the sink address of either family
+    int addFlow(const Protocol& protocol, const struct sockaddr* addr, const socklen_t& length);
+    void stop();
+    void clear();
+
+    int numFlows() const;
+    Protocol protocol(const int& flow) const;
+    QString address(const int& flow) const;
+    quint64 bytes(const int& flow) const;
+    // mean throughput in Mbit/s since the flow was added
+    double throughput(const int& flow) const;
+    QString error(const int& flow) const;
+
+private:
+    class Impl;
+    Impl* impl;
+};
+
+}
+
+#endif // rqt_ping__load_generator_H
@@ -0,0 +1,73 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__loss_statistics_H
+#define rqt_ping__loss_statistics_H
+
+#include <QtGlobal>
+
+namespace rqt_ping {
+
+class LossStatistics
+{
+public:
+    LossStatistics(const int& minGap = 16);
+
+    void clear();
+    // probe outcomes in sequence order
+    void add(const bool& received);
+
+    quint64 count() const { return n; }
+    quint64 lost() const { return lost_; }
+
+    // runs of consecutive losses, the last bucket counts every longer run
+    enum { MaxRunLength = 32 };
+    quint64 numRuns(const int& length) const;
+    double meanRunLength() const;
+    int maxRunLength() const;
+
+    // bursts and gaps of RFC 3611: a burst starts and ends with a loss and holds
+    // no run of minGap received probes, isolated losses belong to the gaps
+    quint64 numBursts() const;
+    double burstDensity() const;
+    double gapDensity() const;
+    double meanBurstLength() const;
+    double meanGapLength() const;
+
+    // two-state Gilbert-Elliott model fitted to the bursts and gaps:
+    // p from good to bad, r from bad to good, 1 - k and 1 - h the loss probabilities in good and bad
+    double p() const;
+    double r() const;
+    double k() const;
+    double h() const;
+
+private:
+    struct Segments {
+        quint64 bursts;
+        quint64 burst_packets;
+        quint64 burst_losses;
+        quint64 gap_packets;
+        quint64 gap_losses;
+    };
+
+    // counts the probes since the last finished burst as well
+    Segments segments() const;
+
+    int min_gap;
+    quint64 n;
+    quint64 lost_;
+    quint64 runs[MaxRunLength];
+    quint64 num_runs;
+    int run_length;
+    int max_run_length;
+
+    Segments closed;
+    quint64 received_run;
+    quint64 pending_packets;
+    quint64 pending_losses;
+};
+
+}
+
+#endif // rqt_ping__loss_statistics_H
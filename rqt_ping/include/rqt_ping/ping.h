@@ -6,6 +6,13 @@
 #define rqt_ping__ping_H
 
 #include <QObject>
+#include <QStringList>
+
+#include "rqt_ping/load_generator.h"
+#include "rqt_ping/loss_statistics.h"
+#include "rqt_ping/ping_sample.h"
+#include "rqt_ping/rtt_statistics.h"
+#include "rqt_ping/size_statistics.h"
 
 namespace rqt_ping {
 
@@ -16,10 +23,66 @@ public:
     Ping(QObject* parent = nullptr);
     ~Ping();
 
+    enum Mode { Icmp, TcpConnect, UdpEcho, Twamp };
+
     void setAddress(const QString& address);
+    void setAddresses(const QStringList& addresses);
     void setCount(const int& count);
     void setWait(const double& second);
 
+    // unanswered probes count as lost after the timeout, later replies as late
+    void setTimeout(const double& second);
+    double timeout() const;
+
+    void setMode(const Mode& mode);
+    Mode mode() const;
+
+    // address family of the probes: any takes IPv4 when a name has both, dual stack probes
+    // each name over both families as targets of their own, "name (IPv4)" and "name (IPv6)"
+    enum Family { AnyFamily, Ipv4, Ipv6, DualStack };
+    void setFamily(const Family& family);
+    Family family() const;
+
+    // latency under load: after the idle time, bulk flows run to the discard sink
+    // on the targets and the samples of both phases are kept apart
+    enum Load { NoLoad, TcpLoad, UdpLoad };
+    void setLoad(const Load& load, const int& numFlows = 1);
+    Load load() const;
+    int numLoadFlows() const;
+    void setLoadPort(const int& port);
+    void setLoadRate(const double& mbps);
+    void setIdleTime(const double& second);
+    bool isLoaded() const;
+    const LoadGenerator& loadGenerator() const;
+
+    // path MTU and size sweep of the ICMP and UDP echo modes: the probes cycle through
+    // the IP packet sizes from minSize to maxSize with DF set, 0 as maxSize turns it off
+    void setSizeSweep(const int& minSize, const int& maxSize, const int& step = 64);
+    bool sizeSweep() const;
+
+    // per-hop latency of the ICMP mode, mtr-style: every address turns into one target per hop,
+    // "name hop N", and the hops are probed in parallel with their TTL, 0 turns it off
+    void setMaxHops(const int& hops);
+    int maxHops() const;
+
+    // live statistics and raw samples for other processes in a POSIX shared-memory
+    // segment of this name (e.g. "/rqt_ping"), read with ShmStatsReader of shm_stats.h;
+    // a name that another engine holds is not taken over
+    void setSharedMemory(const QString& name);
+    QString sharedMemory() const;
+
+    // records every run into a session file, replayed with SessionReader
+    void setRecordFile(const QString& fileName);
+    QString recordFile() const;
+
+    // destination port of the TCP and UDP probes, 0 selects the default of the mode
+    void setPort(const int& port);
+    int port() const;
+
+    // sub-200 ms intervals with kernel receive/transmit timestamps
+    void setHighRate(const bool& on);
+    bool highRate() const;
+
     void start();
     void stop();
 
@@ -29,13 +92,62 @@ public:
     double mdev() const;
     double loss() const;
 
+    double p50() const;
+    double p90() const;
+    double p99() const;
+    double p999() const;
+
     int transmittedPackets() const;
     int receivedPackets() const;
+    int lostPackets() const;
+    const RttStatistics& statistics() const;
+
+    // per-target results for every address that could be resolved
+    int numTargets() const;
+    QString address(const int& index) const;
+    int transmittedPackets(const int& index) const;
+    int receivedPackets(const int& index) const;
+    double loss(const int& index) const;
+    int lostPackets(const int& index) const;
+    int duplicatePackets(const int& index) const;
+    int reorderedPackets(const int& index) const;
+    int latePackets(const int& index) const;
+    double lastRtt(const int& index) const;
+    double jitter(const int& index) const;
+    const RttStatistics& statistics(const int& index) const;
+    Family targetFamily(const int& index) const;
+    // the replies of all targets of one family, Ipv4 or Ipv6
+    const RttStatistics& familyStatistics(const Family& family) const;
+    const LossStatistics& lossStatistics(const int& index) const;
+    const SizeStatistics& sizeStatistics(const int& index) const;
+    const RttStatistics& idleStatistics(const int& index) const;
+    const RttStatistics& loadedStatistics(const int& index) const;
+
+    // TTL of the probes of a target in the per-hop mode, 0 outside it
+    int hop(const int& index) const;
+    // the router or host that answered the latest probe of a hop, empty until one did
+    QString responder(const int& index) const;
+    // hops behind the destination stop being probed once it has answered a nearer one
+    bool beyondDestination(const int& index) const;
+
+    // one-way results of the TWAMP mode in milliseconds,
+    // split with the clock offset (remote minus local) of the fastest recent round trip
+    const RttStatistics& forwardStatistics(const int& index) const;
+    const RttStatistics& reverseStatistics(const int& index) const;
+    double forwardJitter(const int& index) const;
+    double reverseJitter(const int& index) const;
+    double clockOffset(const int& index) const;
 
     bool started();
 
+    // splits a list of names and expands the CIDR ranges of up to 4096 hosts, a larger range
+    // is kept as it is and reported by start()
+    static QStringList expandAddresses(const QString& text);
+
 signals:
     void output(QString text);
+    void sampled(rqt_ping::PingSample sample);
+    void targetUpdated(int index);
 
 private:
     class Impl;
@@ -0,0 +1,42 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__ping_log_model_H
+#define rqt_ping__ping_log_model_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+
+#include "rqt_ping/ping_sample.h"
+
+namespace rqt_ping {
+
+class PingLogModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    PingLogModel(QObject* parent = nullptr);
+    ~PingLogModel();
+
+    void setCapacity(const int& capacity);
+    int capacity() const;
+    void setTargets(const QStringList& targets);
+
+    void append(const PingSample& sample);
+    // a burst of samples with one insertion, only the newest that fit are kept
+    void append(const PingSample* samples, const int& count);
+    void append(const QString& text);
+    void clear();
+
+    virtual int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+    class Impl;
+    Impl* impl;
+};
+
+}
+
+#endif // rqt_ping__ping_log_model_H
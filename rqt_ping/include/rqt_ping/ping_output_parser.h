@@ -0,0 +1,56 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__ping_output_parser_H
+#define rqt_ping__ping_output_parser_H
+
+#include <QtGlobal>
+
+#include <functional>
+#include <vector>
+
+namespace rqt_ping {
+
+struct PingReply {
+    double time;    // milliseconds
+    int sequence;
+    int ttl;        // -1 when absent
+    int bytes;
+    bool is_duplicate;
+};
+
+class PingOutputParser
+{
+public:
+    PingOutputParser();
+
+    typedef std::function<void(const PingReply& reply)> ReplyFunction;
+    typedef std::function<void(const char* line, int length)> MessageFunction;
+
+    void setReplyFunction(const ReplyFunction& function) { replyFunction = function; }
+    void setMessageFunction(const MessageFunction& function) { messageFunction = function; }
+
+    // chunks may end anywhere, an incomplete line is carried over to the next call
+    void feed(const char* data, const int& size);
+    void finish();
+    void clear();
+
+    quint64 numLines() const { return num_lines; }
+    quint64 numReplies() const { return num_replies; }
+
+    static bool parseReply(const char* line, const int& length, PingReply& reply);
+
+private:
+    void parseLine(const char* line, const int& length);
+
+    ReplyFunction replyFunction;
+    MessageFunction messageFunction;
+    std::vector<char> carry;
+    quint64 num_lines;
+    quint64 num_replies;
+};
+
+}
+
+#endif // rqt_ping__ping_output_parser_H
@@ -0,0 +1,42 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__ping_sample_H
+#define rqt_ping__ping_sample_H
+
+#include <QMetaType>
+#include <QtGlobal>
+
+namespace rqt_ping {
+
+struct PingSample {
+    enum Flag {
+        Reply = 0x01,
+        Tcp = 0x02,       // rtt is the TCP connect time
+        Udp = 0x04,       // rtt is the round trip through an echo reflector
+        Refused = 0x08,   // the TCP port answered with a reset
+        OneWay = 0x10,    // forward and reverse are valid
+        Duplicate = 0x20, // the probe had been answered before
+        Reordered = 0x40, // a later probe had been answered before
+        Late = 0x80,      // the reply arrived after the probe had timed out
+        Loaded = 0x100,   // the load flows were running
+        Hop = 0x200       // a router on the way answered with time exceeded
+    };
+
+    qint64 time;      // reception time in microseconds since the epoch
+    double rtt;       // round-trip time in milliseconds
+    qint32 target;    // index of the target in the Ping object
+    quint16 sequence;
+    quint16 flags;
+    qint16 ttl;       // -1 when unknown
+    quint16 bytes;
+    double forward;   // one-way delays in milliseconds
+    double reverse;
+};
+
+}
+
+Q_DECLARE_METATYPE(rqt_ping::PingSample)
+
+#endif // rqt_ping__ping_sample_H
@@ -0,0 +1,87 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__ping_worker_H
+#define rqt_ping__ping_worker_H
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+#include "rqt_ping/ping_sample.h"
+#include "rqt_ping/rtt_pyramid.h"
+#include "rqt_ping/rtt_statistics.h"
+
+namespace rqt_ping {
+
+class Ping;
+
+// one row of the summary table
+struct PingRow {
+    int transmitted;
+    int received;
+    double loss;
+    int duplicates;
+    int reordered;
+    int late;
+    double last;
+    quint64 count;
+    double min;
+    double avg;
+    double max;
+    double mdev;
+    double p99;
+    QString responder;  // per-hop mode only
+    bool beyond;        // a hop behind the destination
+
+    void setStatistics(const RttStatistics& statistics);
+};
+
+// everything that changed since the last PingWorker::takeDelta()
+struct PingDelta {
+    QVector<PingSample> samples;
+    QStringList lines;
+    QVector<int> line_positions;    // samples that came before each line
+    QVector<int> indices;           // targets whose rows changed
+    QVector<PingRow> rows;
+    QVector<RttPyramid::Bucket> chart_buckets;  // the replies of the chart target at level 0
+    int dropped;                    // samples dropped while nobody took the deltas
+};
+
+// runs the ping engine in a thread of its own: the samples are gathered there and the
+// rows are refreshed at most once per frame, so the cost of the UI follows the frame rate
+// rather than the packet rate
+class PingWorker : public QObject
+{
+    Q_OBJECT
+public:
+    PingWorker(QObject* parent = nullptr);
+    ~PingWorker();
+
+    enum { FrameInterval = 33 };
+
+    // lives in the worker thread, only to be configured and read while it is stopped
+    Ping* ping() const;
+
+    void start();
+    void stop();
+    bool started() const;
+    QStringList addresses() const;
+    // the target whose replies are binned for the chart, the buckets not yet taken are dropped
+    void setChartTarget(const int& index);
+
+    PingDelta takeDelta();
+
+signals:
+    // carries start and stop into the worker thread and waits for them
+    void requested(int request);
+
+private:
+    class Impl;
+    Impl* impl;
+};
+
+}
+
+#endif // rqt_ping__ping_worker_H
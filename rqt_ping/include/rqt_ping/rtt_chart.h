@@ -0,0 +1,42 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__rtt_chart_H
+#define rqt_ping__rtt_chart_H
+
+#include <QVector>
+#include <QWidget>
+
+#include "rqt_ping/ping_sample.h"
+#include "rqt_ping/rtt_pyramid.h"
+
+namespace rqt_ping {
+
+class RttChart : public QWidget
+{
+    Q_OBJECT
+public:
+    RttChart(QWidget* parent = nullptr);
+    ~RttChart();
+
+    void addSample(const PingSample& sample);
+    void addBuckets(const QVector<RttPyramid::Bucket>& buckets);
+    void addCounts(const int& transmitted, const int& received);
+    void clear();
+
+    // visible time span in seconds, 0 shows everything that is kept
+    void setSpan(const double& second);
+    double span() const;
+
+protected:
+    virtual void paintEvent(QPaintEvent* event) override;
+
+private:
+    class Impl;
+    Impl* impl;
+};
+
+}
+
+#endif // rqt_ping__rtt_chart_H
@@ -0,0 +1,68 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__rtt_pyramid_H
+#define rqt_ping__rtt_pyramid_H
+
+#include <QtGlobal>
+
+#include <vector>
+
+namespace rqt_ping {
+
+class RttPyramid
+{
+public:
+    enum { DefaultResolution = 100000 };
+
+    // level 0 buckets are resolution long, every level above is factor times coarser
+    RttPyramid(const qint64& resolution = DefaultResolution, const int& numLevels = 6,
+        const int& capacity = 4096, const int& factor = 4);
+
+    struct Bucket {
+        qint64 start;    // microseconds since the epoch
+        float min;
+        float max;
+        double sum;
+        quint32 count;
+        quint32 transmitted;
+        quint32 received;
+
+        double mean() const { return count ? sum / (double)count : 0.0; }
+        double loss() const { return transmitted ? 100.0 * (1.0 - qMin(1.0, (double)received / (double)transmitted)) : 0.0; }
+    };
+
+    void clear();
+    void add(const qint64& time, const double& rtt);
+    // merges a bucket that was binned elsewhere and fits into one of level 0
+    void addBucket(const Bucket& bucket);
+    void addCounts(const qint64& time, const int& transmitted, const int& received);
+
+    int numLevels() const { return (int)levels.size(); }
+    qint64 width(const int& level) const { return levels[level].width; }
+    int selectLevel(const qint64& span, const int& maxBuckets) const;
+    void buckets(const int& level, const qint64& from, const qint64& to, std::vector<Bucket>& out) const;
+
+    bool isEmpty() const { return last < 0; }
+    qint64 firstTime() const { return first; }
+    qint64 lastTime() const { return last; }
+
+private:
+    struct Level {
+        qint64 width;
+        std::vector<Bucket> ring;
+    };
+
+    Bucket& bucket(Level& level, const qint64& time);
+
+    std::vector<Level> levels;
+    qint64 first;
+    qint64 last;
+    int last_transmitted;
+    int last_received;
+};
+
+}
+
+#endif // rqt_ping__rtt_pyramid_H
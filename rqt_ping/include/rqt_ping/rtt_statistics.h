@@ -0,0 +1,42 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__rtt_statistics_H
+#define rqt_ping__rtt_statistics_H
+
+#include <QtGlobal>
+
+namespace rqt_ping {
+
+class RttStatistics
+{
+public:
+    RttStatistics();
+
+    void clear();
+    void add(const double& rtt);
+
+    quint64 count() const { return n; }
+    double min() const { return n ? min_ : 0.0; }
+    double avg() const { return mean; }
+    double max() const { return n ? max_ : 0.0; }
+    double mdev() const;
+    double percentile(const double& p) const;
+
+    // the histogram spans 1 us to 100 s in milliseconds with 64 log-spaced buckets per decade,
+    // which bounds the percentile error to about 2%
+    enum { BucketsPerDecade = 64, NumDecades = 8, NumBuckets = BucketsPerDecade * NumDecades };
+
+private:
+    quint64 n;
+    double mean;
+    double m2;
+    double min_;
+    double max_;
+    quint64 buckets[NumBuckets];
+};
+
+}
+
+#endif // rqt_ping__rtt_statistics_H
@@ -0,0 +1,78 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__sequence_tracker_H
+#define rqt_ping__sequence_tracker_H
+
+#include <QtGlobal>
+
+#include <functional>
+#include <vector>
+
+namespace rqt_ping {
+
+class SequenceTracker
+{
+public:
+    SequenceTracker(const int& windowSize = 64);
+
+    enum Result { Unknown, InOrder, Reordered, Duplicate, Late };
+
+    // receives the outcome of every probe in sequence order once it is resolved,
+    // a late reply stays a loss when the loss has been passed on already
+    typedef std::function<void(const bool& received)> OutcomeFunction;
+    void setOutcomeFunction(const OutcomeFunction& function) { outcomeFunction = function; }
+
+    // the window is rounded up to a power of two and has to cover the probes in flight
+    void setWindowSize(const int& windowSize);
+    int windowSize() const { return (int)entries.size(); }
+    void clear();
+
+    // times are in nanoseconds on the caller's clock, probes are sent in sequence order
+    void sent(const quint16& sequence, const qint64& time);
+    void setSentTime(const quint16& sequence, const qint64& time);
+    qint64 sentTime(const quint16& sequence) const;
+
+    Result received(const quint16& sequence);
+
+    // marks a probe still in flight as lost, later replies to it count as late
+    bool expire(const quint16& sequence);
+    // marks every probe in flight as lost
+    void finish();
+
+    int pending() const { return pending_; }
+    int lost() const { return lost_; }
+    int duplicates() const { return duplicates_; }
+    int reordered() const { return reordered_; }
+    int late() const { return late_; }
+
+private:
+    enum State { Empty, Pending, Received, Lost };
+
+    struct Entry {
+        qint64 time;
+        quint16 sequence;
+        quint8 state;
+    };
+
+    Entry* find(const quint16& sequence);
+    const Entry* find(const quint16& sequence) const;
+    void advance();
+
+    std::vector<Entry> entries;
+    qint64 mask;
+    qint64 highest_sent;
+    qint64 highest_received;
+    qint64 next_outcome;
+    OutcomeFunction outcomeFunction;
+    int pending_;
+    int lost_;
+    int duplicates_;
+    int reordered_;
+    int late_;
+};
+
+}
+
+#endif // rqt_ping__sequence_tracker_H
@@ -0,0 +1,77 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__session_format_H
+#define rqt_ping__session_format_H
+
+#include <QtGlobal>
+
+namespace rqt_ping {
+
+// columnar ping session file in host byte order:
+//   SessionFileHeader
+//   blocks of up to block_size samples, each a SessionBlockHeader followed by the columns
+//     time qint64, rtt float, forward float, reverse float, target qint32,
+//     sequence quint16, flags quint16, ttl qint16, bytes quint16, padded to 8 bytes
+//   SessionTargetEntry per target, SessionIndexEntry per block and the SessionTrailer
+// a file without the trailer (the recorder died) is still read block by block
+
+const char SessionMagic[8] = { 'R', 'Q', 'T', 'P', 'S', 'E', 'S', '1' };
+const char SessionEndMagic[8] = { 'R', 'Q', 'T', 'P', 'E', 'N', 'D', '1' };
+const quint32 SessionBlockMagic = 0x4b4c4250; // "PBLK"
+const quint32 SessionVersion = 1;
+const int SessionAddressLength = 64;
+
+struct SessionFileHeader {
+    char magic[8];
+    quint32 version;
+    quint32 block_size;
+    qint64 start_time;  // microseconds since the epoch
+    quint32 mode;       // Ping::Mode
+    quint32 reserved;
+};
+
+struct SessionBlockHeader {
+    quint32 magic;
+    quint32 count;
+    qint64 first_time;
+    qint64 last_time;
+    quint64 reserved;
+};
+
+struct SessionTargetEntry {
+    char address[SessionAddressLength];
+    quint32 transmitted;
+    quint32 lost;
+};
+
+struct SessionIndexEntry {
+    quint64 offset;
+    quint32 count;
+    quint32 reserved;
+    qint64 first_time;
+    qint64 last_time;
+};
+
+struct SessionTrailer {
+    quint64 targets_offset;
+    quint32 num_targets;
+    quint32 num_blocks;
+    quint64 index_offset;
+    quint64 num_samples;
+    char magic[8];
+};
+
+// bytes of the columns of one sample and of a whole block
+const int SessionSampleSize = 8 + 4 + 4 + 4 + 4 + 2 + 2 + 2 + 2;
+
+inline quint64 sessionBlockLength(const quint32& count)
+{
+    quint64 length = sizeof(SessionBlockHeader) + (quint64)count * SessionSampleSize;
+    return (length + 7) & ~(quint64)7;
+}
+
+}
+
+#endif // rqt_ping__session_format_H
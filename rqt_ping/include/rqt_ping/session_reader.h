@@ -0,0 +1,62 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__session_reader_H
+#define rqt_ping__session_reader_H
+
+#include <QString>
+
+#include "rqt_ping/ping_sample.h"
+
+namespace rqt_ping {
+
+// maps a session file of session_format.h, the columns are read in place
+class SessionReader
+{
+public:
+    SessionReader();
+    ~SessionReader();
+
+    bool open(const QString& fileName);
+    void close();
+    bool isOpen() const;
+    // false when the recorder never wrote the trailer, the counts then come from the samples
+    bool isComplete() const;
+
+    qint64 startTime() const;
+    int mode() const;
+
+    int numTargets() const;
+    QString address(const int& index) const;
+    int transmittedPackets(const int& index) const;
+    int lostPackets(const int& index) const;
+
+    quint64 numSamples() const;
+    PingSample sample(const quint64& index) const;
+
+    int numBlocks() const;
+    int blockSize(const int& block) const;
+    qint64 firstTime(const int& block) const;
+    qint64 lastTime(const int& block) const;
+    // the first block that ends at or after the time
+    int findBlock(const qint64& time) const;
+
+    const qint64* times(const int& block) const;
+    const float* rtts(const int& block) const;
+    const float* forwards(const int& block) const;
+    const float* reverses(const int& block) const;
+    const qint32* targets(const int& block) const;
+    const quint16* sequences(const int& block) const;
+    const quint16* flags(const int& block) const;
+    const qint16* ttls(const int& block) const;
+    const quint16* bytes(const int& block) const;
+
+private:
+    class Impl;
+    Impl* impl;
+};
+
+}
+
+#endif // rqt_ping__session_reader_H
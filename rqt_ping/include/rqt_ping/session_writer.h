@@ -0,0 +1,41 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__session_writer_H
+#define rqt_ping__session_writer_H
+
+#include <QStringList>
+
+#include "rqt_ping/ping_sample.h"
+
+namespace rqt_ping {
+
+// appends samples to a session file of session_format.h, one block at a time
+class SessionWriter
+{
+public:
+    SessionWriter();
+    ~SessionWriter();
+
+    enum { DefaultBlockSize = 4096 };
+
+    bool open(const QString& fileName, const QStringList& addresses, const int& mode,
+        const int& blockSize = DefaultBlockSize);
+    bool isOpen() const;
+    QString errorString() const;
+
+    void append(const PingSample& sample);
+    // the probes that got no reply are only known to the engine
+    void setCounts(const int& index, const int& transmitted, const int& lost);
+    // writes the last block, the targets and the index
+    bool close();
+
+private:
+    class Impl;
+    Impl* impl;
+};
+
+}
+
+#endif // rqt_ping__session_writer_H
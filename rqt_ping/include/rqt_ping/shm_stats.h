@@ -0,0 +1,227 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__shm_stats_H
+#define rqt_ping__shm_stats_H
+
+// layout of the shared-memory export of Ping and a header-only reader, which needs
+// neither Qt nor the rqt_ping library (link with -lrt on glibc older than 2.34)
+
+#include <atomic>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace rqt_ping {
+
+const uint32_t ShmMagic = 0x52515450; // "RQTP"
+const uint32_t ShmVersion = 1;
+const int ShmAddressLength = 64;
+
+// one raw sample, the fields follow PingSample
+struct ShmSample {
+    int64_t time;        // reception time in microseconds since the epoch
+    double rtt;          // milliseconds
+    int32_t target;
+    uint16_t sequence;
+    uint16_t flags;      // PingSample::Flag
+    int16_t ttl;
+    uint16_t bytes;
+    uint32_t reserved;
+    double forward;
+    double reverse;
+};
+
+struct ShmStats {
+    uint64_t transmitted;
+    uint64_t received;
+    uint64_t lost;
+    uint64_t duplicates;
+    uint64_t reordered;
+    uint64_t late;
+    double loss;         // percent
+    double min;          // milliseconds from here on
+    double avg;
+    double max;
+    double mdev;
+    double p50;
+    double p90;
+    double p99;
+    double p999;
+    double jitter;
+    double last_rtt;
+};
+
+struct ShmTargetStats {
+    char address[ShmAddressLength];
+    ShmStats stats;
+};
+
+// the segment holds the header, max_targets ShmTargetStats and ring_size ShmSample in a row
+struct ShmHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t max_targets;
+    uint32_t ring_size;  // a power of two
+
+    // seqlock of the snapshot: odd while the engine writes, readers retry on a change
+    alignas(64) std::atomic<uint32_t> sequence;
+    uint32_t num_targets;  // may exceed max_targets, the rest only count into the aggregate
+    uint64_t run;          // incremented by every start, target indices change with it
+    int64_t update_time;   // microseconds since the epoch
+    int32_t started;
+    ShmStats aggregate;
+
+    // single-producer/single-consumer ring of samples, the engine drops samples
+    // rather than wait for the consumer
+    alignas(64) std::atomic<uint64_t> head;
+    std::atomic<uint64_t> dropped;
+    alignas(64) std::atomic<uint64_t> tail;
+};
+
+inline size_t shmSegmentSize(const uint32_t& maxTargets, const uint32_t& ringSize)
+{
+    return sizeof(ShmHeader) + maxTargets * sizeof(ShmTargetStats) + ringSize * sizeof(ShmSample);
+}
+
+inline ShmTargetStats* shmTargets(ShmHeader* header)
+{
+    return (ShmTargetStats*)(header + 1);
+}
+
+inline ShmSample* shmRing(ShmHeader* header)
+{
+    return (ShmSample*)(shmTargets(header) + header->max_targets);
+}
+
+struct ShmSnapshot {
+    uint64_t run;
+    int64_t update_time;
+    bool started;
+    uint32_t num_targets;
+    ShmStats aggregate;
+    std::vector<ShmTargetStats> targets;
+};
+
+// the engine creates the segment with mode 0644: any user may open it read-only and take
+// snapshots, consuming the samples moves the tail of the ring and so needs write access,
+// i.e. the user of the engine
+class ShmStatsReader
+{
+public:
+    enum Access { ReadOnly, Consumer };
+
+    ShmStatsReader() : header(nullptr), size(0), access(ReadOnly) { }
+    ~ShmStatsReader() { close(); }
+
+    // the name as given to Ping::setSharedMemory, e.g. "/rqt_ping", a single consumer
+    // at a time may drain the samples
+    bool open(const std::string& name, const Access& access = ReadOnly)
+    {
+        close();
+        int fd = shm_open(name.c_str(), access == Consumer ? O_RDWR : O_RDONLY, 0);
+        if(fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(ShmHeader)) {
+            ::close(fd);
+            return false;
+        }
+        int protection = access == Consumer ? PROT_READ | PROT_WRITE : PROT_READ;
+        void* address = mmap(nullptr, st.st_size, protection, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(address == MAP_FAILED) {
+            return false;
+        }
+        header = (ShmHeader*)address;
+        size = st.st_size;
+        this->access = access;
+        if(header->magic != ShmMagic || header->version != ShmVersion
+                || size < shmSegmentSize(header->max_targets, header->ring_size)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if(header) {
+            munmap(header, size);
+            header = nullptr;
+            size = 0;
+            access = ReadOnly;
+        }
+    }
+
+    bool isOpen() const { return header != nullptr; }
+    bool isConsumer() const { return header != nullptr && access == Consumer; }
+
+    // any number of readers may take snapshots, none of them holds up the engine
+    bool snapshot(ShmSnapshot& snapshot, const int& maxRetries = 1000) const
+    {
+        if(!header) {
+            return false;
+        }
+        for(int i = 0; i < maxRetries; ++i) {
+            uint32_t begin = header->sequence.load(std::memory_order_acquire);
+            if(begin & 1) {
+                continue;
+            }
+            snapshot.run = header->run;
+            snapshot.update_time = header->update_time;
+            snapshot.started = header->started != 0;
+            snapshot.num_targets = header->num_targets;
+            snapshot.aggregate = header->aggregate;
+            uint32_t num_slots = snapshot.num_targets < header->max_targets ? snapshot.num_targets : header->max_targets;
+            snapshot.targets.resize(num_slots);
+            if(num_slots > 0) {
+                memcpy(&snapshot.targets[0], shmTargets(header), num_slots * sizeof(ShmTargetStats));
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(header->sequence.load(std::memory_order_relaxed) == begin) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // only the consumer gets the samples, at most maxSamples of them
+    int readSamples(ShmSample* samples, const int& maxSamples)
+    {
+        if(!isConsumer()) {
+            return 0;
+        }
+        uint64_t tail = header->tail.load(std::memory_order_relaxed);
+        uint64_t head = header->head.load(std::memory_order_acquire);
+        int n = 0;
+        const ShmSample* ring = shmRing(header);
+        while(tail != head && n < maxSamples) {
+            samples[n++] = ring[tail & (header->ring_size - 1)];
+            ++tail;
+        }
+        header->tail.store(tail, std::memory_order_release);
+        return n;
+    }
+
+    uint64_t droppedSamples() const
+    {
+        return header ? header->dropped.load(std::memory_order_relaxed) : 0;
+    }
+
+private:
+    ShmHeader* header;
+    size_t size;
+    Access access;
+};
+
+}
+
+#endif // rqt_ping__shm_stats_H
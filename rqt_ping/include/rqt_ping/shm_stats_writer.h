@@ -0,0 +1,50 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__shm_stats_writer_H
+#define rqt_ping__shm_stats_writer_H
+
+#include <QStringList>
+
+#include "rqt_ping/ping_sample.h"
+#include "rqt_ping/shm_stats.h"
+
+namespace rqt_ping {
+
+// the producer side of shm_stats.h, only ever called from the probe engine
+class ShmStatsWriter
+{
+public:
+    ShmStatsWriter();
+    ~ShmStatsWriter();
+
+    enum { DefaultMaxTargets = 1024, DefaultRingSize = 16384 };
+
+    bool open(const QString& name, const int& maxTargets = DefaultMaxTargets,
+        const int& ringSize = DefaultRingSize);
+    void close();
+    bool isOpen() const;
+    QString name() const;
+
+    // starts a new run, the samples already in the ring stay for the consumer
+    void reset(const QStringList& addresses);
+
+    // the snapshot is filled in between, readers retry until it is complete
+    void beginUpdate();
+    ShmStats& aggregate();
+    // nullptr beyond the slots of the segment
+    ShmStats* target(const int& index);
+    void endUpdate(const bool& started);
+
+    // never blocks, the sample is dropped when the consumer lags behind
+    void push(const PingSample& sample);
+
+private:
+    class Impl;
+    Impl* impl;
+};
+
+}
+
+#endif // rqt_ping__shm_stats_writer_H
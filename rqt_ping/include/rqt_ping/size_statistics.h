@@ -0,0 +1,56 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__size_statistics_H
+#define rqt_ping__size_statistics_H
+
+#include <QVector>
+
+namespace rqt_ping {
+
+class SizeStatistics
+{
+public:
+    SizeStatistics();
+
+    // IP packet sizes in bytes, from minSize up to maxSize in steps
+    void setRange(const int& minSize, const int& maxSize, const int& step);
+    void clear();
+
+    int numSizes() const { return min_rtts.size(); }
+    int size(const int& index) const { return min_size + index * step; }
+    quint64 count(const int& index) const { return counts[index]; }
+    double minRtt(const int& index) const { return min_rtts[index]; }
+
+    void add(const int& size, const double& rtt);
+    // MTU reported by a fragmentation needed error or the local interface, the smallest is kept
+    void setMtu(const int& mtu);
+
+    int largestReply() const { return largest_reply; }
+    int reportedMtu() const { return reported_mtu; }
+    // the reported MTU, otherwise the largest packet that came back
+    int pathMtu() const;
+
+    // least squares fit of the minimum rtt [ms] against the size [bytes], the minimum
+    // leaves out queueing so what remains grows with the serialization delay
+    double slope() const;
+    double intercept() const;
+    // the echo travels both ways at the same size, so half the slope is spent per direction;
+    // every store-and-forward hop adds to it, so this is a lower bound of the bottleneck [Mbit/s]
+    double bottleneckRate() const;
+
+private:
+    void fit(double& slope, double& intercept) const;
+
+    int min_size;
+    int step;
+    QVector<double> min_rtts;
+    QVector<quint64> counts;
+    int largest_reply;
+    int reported_mtu;
+};
+
+}
+
+#endif // rqt_ping__size_statistics_H
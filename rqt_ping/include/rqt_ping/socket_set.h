@@ -0,0 +1,36 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__socket_set_H
+#define rqt_ping__socket_set_H
+
+#include <QtGlobal>
+
+#include <functional>
+
+namespace rqt_ping {
+
+class SocketSet
+{
+public:
+    SocketSet();
+    ~SocketSet();
+
+    typedef std::function<void(int fd, quint32 events)> Callback;
+
+    bool add(const int& fd, const Callback& callback, const quint32& events);
+    bool modify(const int& fd, const quint32& events);
+    void remove(const int& fd);
+    void clear();
+
+    int size() const;
+
+private:
+    class Impl;
+    Impl* impl;
+};
+
+}
+
+#endif // rqt_ping__socket_set_H
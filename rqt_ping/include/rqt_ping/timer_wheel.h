@@ -0,0 +1,47 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__timer_wheel_H
+#define rqt_ping__timer_wheel_H
+
+#include <QtGlobal>
+
+#include <vector>
+
+namespace rqt_ping {
+
+class TimerWheel
+{
+public:
+    TimerWheel(const int& numSlots = 1024, const qint64& resolution = 1000000);
+
+    // entries due before now are clamped to it, so the wheel has to start from the present
+    void clear(const qint64& now = 0);
+    void setResolution(const qint64& resolution);
+    qint64 resolution() const { return resolution_; }
+
+    // times are in nanoseconds on the caller's monotonic clock
+    void schedule(const int& id, const qint64& when);
+    int expire(const qint64& now, std::vector<int>& ids);
+    qint64 nextExpiry() const;
+
+    bool isEmpty() const { return size_ == 0; }
+    int size() const { return size_; }
+
+private:
+    struct Entry {
+        int id;
+        qint64 when;
+        qint64 tick;
+    };
+
+    std::vector<std::vector<Entry>> spokes;
+    qint64 resolution_;
+    qint64 current;
+    int size_;
+};
+
+}
+
+#endif // rqt_ping__timer_wheel_H
@@ -0,0 +1,66 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#ifndef rqt_ping__twamp_packet_H
+#define rqt_ping__twamp_packet_H
+
+#include <QtGlobal>
+
+#include <endian.h>
+
+namespace rqt_ping {
+
+// unauthenticated TWAMP-light test packets (RFC 5357, 4.1.2 and 4.2.1), all fields in network byte order
+
+#pragma pack(push, 1)
+
+struct TwampSenderPacket {
+    quint32 sequence;
+    quint64 timestamp;
+    quint16 error_estimate;
+};
+
+struct TwampReflectorPacket {
+    quint32 sequence;
+    quint64 timestamp;
+    quint16 error_estimate;
+    quint16 mbz;
+    quint64 receive_timestamp;
+    quint32 sender_sequence;
+    quint64 sender_timestamp;
+    quint16 sender_error_estimate;
+    quint16 mbz2;
+    quint8 sender_ttl;
+};
+
+#pragma pack(pop)
+
+// not synchronized, scale 0, multiplier 1
+const quint16 TwampErrorEstimate = 0x0001;
+// that of rqt_ping_twamp, which runs without root; reflectors on the well-known 862 take a port setting
+const int DefaultTwampPort = 10862;
+
+// the sender pads its packets to the reflector size, so both directions carry the same length
+const int TwampPacketLength = sizeof(TwampReflectorPacket);
+
+inline quint64 toNtpTimestamp(const qint64& nanoseconds)
+{
+    const quint64 NtpEpochOffset = 2208988800ULL;
+    quint64 second = (quint64)(nanoseconds / 1000000000LL) + NtpEpochOffset;
+    quint64 fraction = ((quint64)(nanoseconds % 1000000000LL) << 32) / 1000000000ULL;
+    return htobe64((second << 32) | fraction);
+}
+
+inline qint64 fromNtpTimestamp(const quint64& timestamp)
+{
+    const quint64 NtpEpochOffset = 2208988800ULL;
+    quint64 value = be64toh(timestamp);
+    qint64 second = (qint64)((value >> 32) - NtpEpochOffset);
+    qint64 fraction = (qint64)(((value & 0xffffffffULL) * 1000000000ULL) >> 32);
+    return second * 1000000000LL + fraction;
+}
+
+}
+
+#endif // rqt_ping__twamp_packet_H
@@ -0,0 +1,74 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "rqt_ping/ping_output_parser.h"
+
+using namespace rqt_ping;
+
+namespace {
+
+const int DefaultLines = 1000000;
+const int ChunkSize = 4096;
+
+std::string makeTranscript(const int& numLines)
+{
+    std::ostringstream stream;
+    stream << "PING 192.168.0.1 (192.168.0.1) 56(84) bytes of data.\n";
+    for(int i = 1; i <= numLines; ++i) {
+        stream << "64 bytes from 192.168.0.1: icmp_seq=" << i
+               << " ttl=64 time=" << (i % 97) * 0.137 + 0.021 << " ms\n";
+    }
+    return stream.str();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    // usage: ping_parser_benchmark [transcript] [repeat]
+    std::string transcript;
+    if(argc > 1) {
+        std::ifstream file(argv[1], std::ios::binary);
+        if(!file) {
+            std::cerr << "cannot open " << argv[1] << std::endl;
+            return 1;
+        }
+        std::ostringstream stream;
+        stream << file.rdbuf();
+        transcript = stream.str();
+    } else {
+        transcript = makeTranscript(DefaultLines);
+    }
+    int repeat = argc > 2 ? std::stoi(argv[2]) : 10;
+
+    PingOutputParser parser;
+    double sum = 0.0;
+    parser.setReplyFunction([&](const PingReply& reply){ sum += reply.time; });
+
+    // chunks deliberately cut lines in the middle, as pipe reads do
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < repeat; ++i) {
+        for(size_t offset = 0; offset < transcript.size(); offset += ChunkSize) {
+            size_t size = std::min((size_t)ChunkSize, transcript.size() - offset);
+            parser.feed(transcript.data() + offset, (int)size);
+        }
+        parser.finish();
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    double second = std::chrono::duration<double>(stop - start).count();
+    double lines = (double)parser.numLines();
+    std::cout << parser.numLines() << " lines (" << parser.numReplies() << " replies) in "
+              << second << " s: " << lines / second / 1000000.0 << " Mlines/s, "
+              << (double)transcript.size() * repeat / second / 1048576.0 << " MiB/s"
+              << " (checksum " << sum << ")" << std::endl;
+    return 0;
+}
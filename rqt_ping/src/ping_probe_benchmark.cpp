@@ -0,0 +1,50 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include <QCoreApplication>
+#include <QTimer>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "rqt_ping/ping.h"
+
+using namespace rqt_ping;
+
+int main(int argc, char** argv)
+{
+    // usage: ping_probe_benchmark [addresses] [second] [wait]
+    // every 127.0.0.0/8 address is answered by the loopback interface
+    QCoreApplication app(argc, argv);
+    QString addresses = argc > 1 ? QString(argv[1]) : QString("127.0.0.0/22");
+    double second = argc > 2 ? std::stod(argv[2]) : 5.0;
+    double wait = argc > 3 ? std::stod(argv[3]) : 0.001;
+
+    Ping ping;
+    QObject::connect(&ping, &Ping::output, [&](QString text){
+        std::cerr << text.toLocal8Bit().constData() << std::endl;
+    });
+    ping.setAddresses(Ping::expandAddresses(addresses));
+    ping.setWait(wait);
+    ping.setHighRate(true);
+
+    auto start = std::chrono::steady_clock::now();
+    ping.start();
+    if(ping.numTargets() == 0) {
+        return 1;
+    }
+    QTimer::singleShot((int)(second * 1000.0), [&](){ app.quit(); });
+    app.exec();
+    auto stop = std::chrono::steady_clock::now();
+    ping.stop();
+
+    double elapsed = std::chrono::duration<double>(stop - start).count();
+    std::cout << ping.numTargets() << " targets, " << ping.transmittedPackets() << " probes, "
+              << ping.receivedPackets() << " replies in " << elapsed << " s: "
+              << ping.transmittedPackets() / elapsed << " probes/s, "
+              << ping.receivedPackets() / elapsed << " replies/s, "
+              << "rtt p50/p99 " << ping.p50() << "/" << ping.p99() << " ms" << std::endl;
+    return 0;
+}
@@ -0,0 +1,280 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/load_generator.h"
+
+#include <QTimer>
+#include <QVector>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rqt_ping/socket_set.h"
+
+namespace {
+
+const int ChunkSize = 65536;
+const int DatagramSize = 1400;
+const int PacingInterval = 1;
+const int MaxBurst = 64;
+
+qint64 now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (qint64)ts.tv_sec * 1000000000LL + (qint64)ts.tv_nsec;
+}
+
+}
+
+namespace rqt_ping {
+
+struct LoadFlow {
+    LoadGenerator::Protocol protocol;
+    struct sockaddr_storage addr;
+    int fd;
+    quint64 bytes;
+    qint64 start;
+    qint64 stop;
+    double credit;
+    QString error;
+};
+
+class LoadGenerator::Impl
+{
+public:
+    Impl(SocketSet* sockets);
+    ~Impl();
+
+    void write(const int& flow);
+    void fail(const int& flow, const int& error);
+    void closeFlow(const int& flow);
+    void on_pacingTimer_timeout();
+
+    SocketSet* sockets;
+    QVector<LoadFlow> flows;
+    QTimer pacingTimer;
+    qint64 last_pacing;
+    double udp_rate;
+    char chunk[ChunkSize];
+};
+
+
+LoadGenerator::LoadGenerator(SocketSet* sockets)
+{
+    impl = new Impl(sockets);
+}
+
+LoadGenerator::Impl::Impl(SocketSet* sockets)
+    : sockets(sockets)
+{
+    last_pacing = 0;
+    udp_rate = 100.0;
+    memset(chunk, 0x5a, sizeof(chunk));
+
+    pacingTimer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&pacingTimer, &QTimer::timeout, [&](){ on_pacingTimer_timeout(); });
+}
+
+LoadGenerator::~LoadGenerator()
+{
+    delete impl;
+}
+
+LoadGenerator::Impl::~Impl()
+{
+    for(int i = 0; i < flows.size(); ++i) {
+        closeFlow(i);
+    }
+}
+
+void LoadGenerator::setUdpRate(const double& mbps)
+{
+    if(mbps > 0.0) {
+        impl->udp_rate = mbps;
+    }
+}
+
+double LoadGenerator::udpRate() const
+{
+    return impl->udp_rate;
+}
+
+int LoadGenerator::addFlow(const Protocol& protocol, const struct sockaddr* addr, const socklen_t& length)
+{
+    LoadFlow flow;
+    flow.protocol = protocol;
+    memset(&flow.addr, 0, sizeof(flow.addr));
+    memcpy(&flow.addr, addr, qMin((size_t)length, sizeof(flow.addr)));
+    flow.fd = -1;
+    flow.bytes = 0;
+    flow.start = now();
+    flow.stop = 0;
+    flow.credit = 0.0;
+    impl->flows.push_back(flow);
+    int index = impl->flows.size() - 1;
+
+    int type = protocol == Tcp ? SOCK_STREAM : SOCK_DGRAM;
+    int fd = socket(addr->sa_family, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd < 0) {
+        impl->fail(index, errno);
+        return index;
+    }
+    impl->flows[index].fd = fd;
+
+    // both kinds are connected, so send() needs no address and errors surface on the socket
+    if(::connect(fd, addr, length) < 0 && errno != EINPROGRESS) {
+        impl->fail(index, errno);
+        return index;
+    }
+
+    if(protocol == Tcp) {
+        impl->sockets->add(fd, [this, index](int fd, quint32 events){
+            if(events & (EPOLLERR | EPOLLHUP)) {
+                int error = 0;
+                socklen_t length = sizeof(error);
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+                impl->fail(index, error ? error : ECONNRESET);
+                return;
+            }
+            impl->write(index);
+        }, EPOLLOUT);
+    } else if(!impl->pacingTimer.isActive()) {
+        impl->last_pacing = now();
+        impl->pacingTimer.start(PacingInterval);
+    }
+    return index;
+}
+
+void LoadGenerator::stop()
+{
+    impl->pacingTimer.stop();
+    for(int i = 0; i < impl->flows.size(); ++i) {
+        impl->closeFlow(i);
+    }
+}
+
+void LoadGenerator::clear()
+{
+    stop();
+    impl->flows.clear();
+}
+
+int LoadGenerator::numFlows() const
+{
+    return impl->flows.size();
+}
+
+LoadGenerator::Protocol LoadGenerator::protocol(const int& flow) const
+{
+    return impl->flows[flow].protocol;
+}
+
+QString LoadGenerator::address(const int& flow) const
+{
+    const struct sockaddr_storage& addr = impl->flows[flow].addr;
+    char host[INET6_ADDRSTRLEN];
+    if(addr.ss_family == AF_INET6) {
+        const struct sockaddr_in6* addr6 = (const struct sockaddr_in6*)&addr;
+        inet_ntop(AF_INET6, &addr6->sin6_addr, host, sizeof(host));
+        return QString("[%1]:%2").arg(host).arg(ntohs(addr6->sin6_port));
+    }
+    const struct sockaddr_in* addr4 = (const struct sockaddr_in*)&addr;
+    inet_ntop(AF_INET, &addr4->sin_addr, host, sizeof(host));
+    return QString("%1:%2").arg(host).arg(ntohs(addr4->sin_port));
+}
+
+quint64 LoadGenerator::bytes(const int& flow) const
+{
+    return impl->flows[flow].bytes;
+}
+
+double LoadGenerator::throughput(const int& flow) const
+{
+    const LoadFlow& f = impl->flows[flow];
+    qint64 elapsed = (f.stop ? f.stop : now()) - f.start;
+    return elapsed > 0 ? (double)f.bytes * 8.0 / ((double)elapsed / 1000000000.0) / 1000000.0 : 0.0;
+}
+
+QString LoadGenerator::error(const int& flow) const
+{
+    return impl->flows[flow].error;
+}
+
+void LoadGenerator::Impl::write(const int& flow)
+{
+    // level-triggered, so writing until the socket buffer is full is enough
+    LoadFlow& f = flows[flow];
+    while(f.fd >= 0) {
+        ssize_t ret = ::send(f.fd, chunk, sizeof(chunk), MSG_NOSIGNAL);
+        if(ret < 0) {
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                fail(flow, errno);
+            }
+            break;
+        }
+        f.bytes += ret;
+    }
+}
+
+void LoadGenerator::Impl::fail(const int& flow, const int& error)
+{
+    flows[flow].error = strerror(error);
+    closeFlow(flow);
+}
+
+void LoadGenerator::Impl::closeFlow(const int& flow)
+{
+    LoadFlow& f = flows[flow];
+    if(f.fd >= 0) {
+        sockets->remove(f.fd);
+        ::close(f.fd);
+        f.fd = -1;
+        f.stop = now();
+    }
+}
+
+void LoadGenerator::Impl::on_pacingTimer_timeout()
+{
+    // every UDP flow earns credit at its rate and spends it in whole datagrams,
+    // bursts are capped so a stalled event loop doesn't flood afterwards
+    qint64 time = now();
+    double elapsed = (double)(time - last_pacing) / 1000000000.0;
+    last_pacing = time;
+
+    struct mmsghdr msgs[MaxBurst];
+    struct iovec iov = { chunk, DatagramSize };
+    memset(msgs, 0, sizeof(msgs));
+    for(int i = 0; i < MaxBurst; ++i) {
+        msgs[i].msg_hdr.msg_iov = &iov;
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    for(int i = 0; i < flows.size(); ++i) {
+        LoadFlow& f = flows[i];
+        if(f.protocol != LoadGenerator::Udp || f.fd < 0) {
+            continue;
+        }
+        f.credit = qMin(f.credit + udp_rate * 1000000.0 / 8.0 * elapsed, (double)(MaxBurst * DatagramSize));
+        int count = (int)(f.credit / DatagramSize);
+        if(count == 0) {
+            continue;
+        }
+        int ret = sendmmsg(f.fd, msgs, count, 0);
+        if(ret > 0) {
+            f.bytes += (quint64)ret * DatagramSize;
+            f.credit -= (double)ret * DatagramSize;
+        } else if(ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS
+                && errno != ECONNREFUSED && errno != EINTR) {
+            fail(i, errno);
+        }
+    }
+}
+
+}
@@ -0,0 +1,159 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/loss_statistics.h"
+
+#include <string.h>
+
+namespace rqt_ping {
+
+LossStatistics::LossStatistics(const int& minGap)
+    : min_gap(minGap)
+{
+    clear();
+}
+
+void LossStatistics::clear()
+{
+    n = 0;
+    lost_ = 0;
+    memset(runs, 0, sizeof(runs));
+    num_runs = 0;
+    run_length = 0;
+    max_run_length = 0;
+    memset(&closed, 0, sizeof(closed));
+    received_run = 0;
+    pending_packets = 0;
+    pending_losses = 0;
+}
+
+void LossStatistics::add(const bool& received)
+{
+    ++n;
+    if(received) {
+        if(run_length > 0) {
+            ++runs[qMin(run_length, (int)MaxRunLength) - 1];
+            ++num_runs;
+            run_length = 0;
+        }
+        ++received_run;
+        return;
+    }
+
+    ++lost_;
+    ++run_length;
+    max_run_length = qMax(max_run_length, run_length);
+
+    if(pending_losses > 0 && received_run < (quint64)min_gap) {
+        // the candidate burst goes on through a short run of replies
+        pending_packets += received_run + 1;
+        ++pending_losses;
+    } else {
+        // a long run of replies closes the candidate, a single loss counts towards the gap
+        if(pending_losses > 1) {
+            ++closed.bursts;
+            closed.burst_packets += pending_packets;
+            closed.burst_losses += pending_losses;
+        } else {
+            closed.gap_packets += pending_packets;
+            closed.gap_losses += pending_losses;
+        }
+        closed.gap_packets += received_run;
+        pending_packets = 1;
+        pending_losses = 1;
+    }
+    received_run = 0;
+}
+
+quint64 LossStatistics::numRuns(const int& length) const
+{
+    if(length < 1 || length > MaxRunLength) {
+        return 0;
+    }
+    quint64 count = runs[length - 1];
+    if(run_length > 0 && qMin(run_length, (int)MaxRunLength) == length) {
+        ++count;
+    }
+    return count;
+}
+
+double LossStatistics::meanRunLength() const
+{
+    quint64 count = num_runs + (run_length > 0 ? 1 : 0);
+    return count ? (double)lost_ / (double)count : 0.0;
+}
+
+int LossStatistics::maxRunLength() const
+{
+    return max_run_length;
+}
+
+LossStatistics::Segments LossStatistics::segments() const
+{
+    Segments segments = closed;
+    if(pending_losses > 1) {
+        ++segments.bursts;
+        segments.burst_packets += pending_packets;
+        segments.burst_losses += pending_losses;
+    } else {
+        segments.gap_packets += pending_packets;
+        segments.gap_losses += pending_losses;
+    }
+    segments.gap_packets += received_run;
+    return segments;
+}
+
+quint64 LossStatistics::numBursts() const
+{
+    return segments().bursts;
+}
+
+double LossStatistics::burstDensity() const
+{
+    Segments segments = this->segments();
+    return segments.burst_packets ? (double)segments.burst_losses / (double)segments.burst_packets : 0.0;
+}
+
+double LossStatistics::gapDensity() const
+{
+    Segments segments = this->segments();
+    return segments.gap_packets ? (double)segments.gap_losses / (double)segments.gap_packets : 0.0;
+}
+
+double LossStatistics::meanBurstLength() const
+{
+    Segments segments = this->segments();
+    return segments.bursts ? (double)segments.burst_packets / (double)segments.bursts : 0.0;
+}
+
+double LossStatistics::meanGapLength() const
+{
+    // every burst is preceded by a gap, and one more gap runs until now
+    Segments segments = this->segments();
+    return (double)segments.gap_packets / (double)(segments.bursts + 1);
+}
+
+double LossStatistics::p() const
+{
+    Segments segments = this->segments();
+    return segments.gap_packets ? (double)segments.bursts / (double)segments.gap_packets : 0.0;
+}
+
+double LossStatistics::r() const
+{
+    Segments segments = this->segments();
+    return segments.burst_packets ? (double)segments.bursts / (double)segments.burst_packets : 1.0;
+}
+
+double LossStatistics::k() const
+{
+    return 1.0 - gapDensity();
+}
+
+double LossStatistics::h() const
+{
+    return 1.0 - burstDensity();
+}
+
+}
@@ -6,16 +6,59 @@
 
 #include <QAction>
 #include <QBoxLayout>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDateTime>
 #include <QDialog>
 #include <QDialogButtonBox>
+#include <QDir>
 #include <QDoubleSpinBox>
+#include <QFileDialog>
+#include <QFileInfo>
 #include <QFormLayout>
+#include <QHeaderView>
+#include <QLabel>
 #include <QLineEdit>
+#include <QListView>
+#include <QScrollBar>
 #include <QSpinBox>
-#include <QTextEdit>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QTimer>
 #include <QToolBar>
 
 #include "rqt_ping/ping.h"
+#include "rqt_ping/ping_log_model.h"
+#include "rqt_ping/ping_worker.h"
+#include "rqt_ping/rtt_chart.h"
+#include "rqt_ping/session_reader.h"
+
+namespace {
+
+enum { Address, Sent, Received, Loss, Dup, Reorder, Late, Last, Min, Avg, Max, Mdev, P99, NumColumns };
+
+const QStringList headerLabels = {
+    "Address", "Sent", "Received", "Loss [%]", "Dup", "Reorder", "Late", "Last [ms]",
+    "Min [ms]", "Avg [ms]", "Max [ms]", "Mdev [ms]", "P99 [ms]"
+};
+
+struct SpanInfo {
+    const char* label;
+    double second;
+};
+
+const char* modeLabels[] = { "ICMP echo", "TCP connect", "UDP echo", "TWAMP light" };
+
+const char* loadLabels[] = { "None", "TCP bulk", "UDP bulk" };
+
+const char* familyLabels[] = { "Any", "IPv4", "IPv6", "Dual stack" };
+
+SpanInfo spanInfo[] = {
+    { "1 min", 60.0 }, { "10 min", 600.0 }, { "1 h", 3600.0 },
+    { "6 h", 21600.0 }, { "24 h", 86400.0 }, { "All", 0.0 }
+};
+
+}
 
 namespace rqt_ping {
 
@@ -28,11 +71,53 @@ public:
     int count() const { return countSpin->value(); }
     void setWait(const double& wait) { waitSpin->setValue(wait); }
     double wait() const { return waitSpin->value(); }
+    void setTimeout(const double& timeout) { timeoutSpin->setValue(timeout); }
+    double timeout() const { return timeoutSpin->value(); }
+    void setHighRate(const bool& on) { highRateCheck->setChecked(on); }
+    bool highRate() const { return highRateCheck->isChecked(); }
+    void setMode(const Ping::Mode& mode) { modeCombo->setCurrentIndex(mode); }
+    Ping::Mode mode() const { return (Ping::Mode)modeCombo->currentIndex(); }
+    void setFamily(const Ping::Family& family) { familyCombo->setCurrentIndex(family); }
+    Ping::Family family() const { return (Ping::Family)familyCombo->currentIndex(); }
+    void setPort(const int& port) { portSpin->setValue(port); }
+    int port() const { return portSpin->value(); }
+    void setSweepMin(const int& size) { sweepMinSpin->setValue(size); }
+    int sweepMin() const { return sweepMinSpin->value(); }
+    void setSweepMax(const int& size) { sweepMaxSpin->setValue(size); }
+    int sweepMax() const { return sweepMaxSpin->value(); }
+    void setSweepStep(const int& step) { sweepStepSpin->setValue(step); }
+    int sweepStep() const { return sweepStepSpin->value(); }
+    void setMaxHops(const int& hops) { hopsSpin->setValue(hops); }
+    int maxHops() const { return hopsSpin->value(); }
+    void setLoad(const Ping::Load& load) { loadCombo->setCurrentIndex(load); }
+    Ping::Load load() const { return (Ping::Load)loadCombo->currentIndex(); }
+    void setFlows(const int& flows) { flowsSpin->setValue(flows); }
+    int flows() const { return flowsSpin->value(); }
+    void setIdleTime(const double& second) { idleSpin->setValue(second); }
+    double idleTime() const { return idleSpin->value(); }
+    void setLoadRate(const double& mbps) { rateSpin->setValue(mbps); }
+    double loadRate() const { return rateSpin->value(); }
+    void setLoadPort(const int& port) { sinkPortSpin->setValue(port); }
+    int loadPort() const { return sinkPortSpin->value(); }
 
 private:
 
     QSpinBox* countSpin;
     QDoubleSpinBox* waitSpin;
+    QDoubleSpinBox* timeoutSpin;
+    QCheckBox* highRateCheck;
+    QComboBox* modeCombo;
+    QComboBox* familyCombo;
+    QSpinBox* portSpin;
+    QSpinBox* sweepMinSpin;
+    QSpinBox* sweepMaxSpin;
+    QSpinBox* sweepStepSpin;
+    QSpinBox* hopsSpin;
+    QComboBox* loadCombo;
+    QSpinBox* flowsSpin;
+    QDoubleSpinBox* idleSpin;
+    QDoubleSpinBox* rateSpin;
+    QSpinBox* sinkPortSpin;
     QDialogButtonBox* buttonBox;
 };
 
@@ -48,6 +133,14 @@ public:
     void stop();
     void config();
     void print(const QString& text);
+    void apply(const PingDelta& delta);
+    void setRows(const QStringList& addresses);
+    void setRow(const int& index, const PingRow& row);
+    void setChartTarget(const int& index);
+    void record(const bool& on);
+    void open();
+    void replay();
+    void replayChart();
 
     void createActions();
     void createToolBars();
@@ -55,14 +148,39 @@ public:
     QAction* startAct;
     QAction* stopAct;
     QAction* configAct;
+    QAction* recordAct;
+    QAction* openAct;
 
     QLineEdit* addressLine;
-    QTextEdit* messageText;
+    QTableWidget* summaryTable;
+    QListView* logView;
+    PingLogModel* logModel;
+    RttChart* chart;
+    QComboBox* spanCombo;
+    QTimer frameTimer;
+    int chart_target;
 
     int count;
     double wait;
-
+    double timeout;
+    bool is_high_rate;
+    Ping::Mode mode;
+    Ping::Family family;
+    int port;
+    int sweep_min;
+    int sweep_max;
+    int sweep_step;
+    int max_hops;
+    Ping::Load load;
+    int num_flows;
+    double idle_time;
+    double load_rate;
+    int load_port;
+    QString record_file;
+
+    PingWorker* worker;
     Ping* ping;
+    SessionReader session;
 };
 
 
@@ -85,14 +203,72 @@ MainWindow::Impl::Impl(MainWindow* self)
 
     count = 0;
     wait = 1.0;
-
-    messageText = new QTextEdit;
-
-    ping = new Ping;
-    self->connect(ping, &Ping::output, [&](QString text){ print(text); });
+    timeout = 2.0;
+    is_high_rate = false;
+    mode = Ping::Icmp;
+    family = Ping::AnyFamily;
+    port = 0;
+    sweep_min = 84;
+    sweep_max = 0;
+    sweep_step = 64;
+    max_hops = 0;
+    load = Ping::NoLoad;
+    num_flows = 1;
+    idle_time = 5.0;
+    load_rate = 100.0;
+    load_port = 0;
+
+    summaryTable = new QTableWidget(0, NumColumns);
+    summaryTable->setHorizontalHeaderLabels(headerLabels);
+    summaryTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    summaryTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    summaryTable->verticalHeader()->setVisible(false);
+
+    // a bounded, virtualized log keeps memory and repaint cost flat over long sessions
+    logModel = new PingLogModel(self);
+    logView = new QListView;
+    logView->setModel(logModel);
+    logView->setUniformItemSizes(true);
+    logView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+
+    chart = new RttChart;
+    chart_target = 0;
+    spanCombo = new QComboBox;
+    for(const SpanInfo& info : spanInfo) {
+        spanCombo->addItem(info.label, info.second);
+    }
+    self->connect(spanCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+        [&](int index){ chart->setSpan(spanCombo->itemData(index).toDouble()); });
+
+    auto spanLayout = new QHBoxLayout;
+    spanLayout->addWidget(new QLabel("Span"));
+    spanLayout->addWidget(spanCombo);
+    spanLayout->addStretch();
+
+    QWidget* chartWidget = new QWidget;
+    auto chartLayout = new QVBoxLayout;
+    chartLayout->addLayout(spanLayout);
+    chartLayout->addWidget(chart);
+    chartWidget->setLayout(chartLayout);
+
+    QTabWidget* tabWidget = new QTabWidget;
+    tabWidget->addTab(summaryTable, "Summary");
+    tabWidget->addTab(chartWidget, "Chart");
+    tabWidget->addTab(logView, "Log");
+
+    // the probes are sent and received in the worker thread,
+    // the window only takes what changed once per frame
+    worker = new PingWorker(self);
+    ping = worker->ping();
+    self->connect(&frameTimer, &QTimer::timeout, [&](){ apply(worker->takeDelta()); });
+    frameTimer.start(PingWorker::FrameInterval);
+
+    // the chart follows the target selected in the summary table
+    self->connect(summaryTable, &QTableWidget::currentCellChanged,
+        [&](int currentRow, int, int, int){ setChartTarget(currentRow); });
 
     auto layout = new QVBoxLayout;
-    layout->addWidget(messageText);
+    layout->addWidget(tabWidget);
     widget->setLayout(layout);
 }
 
@@ -110,27 +286,154 @@ void MainWindow::Impl::start()
 {
     stop();
 
-    QString address = addressLine->text();
-    ping->setAddress(address);
+    QStringList addresses = Ping::expandAddresses(addressLine->text());
+    ping->setAddresses(addresses);
     ping->setCount(count);
     ping->setWait(wait);
-    ping->start();
+    ping->setTimeout(timeout);
+    ping->setHighRate(is_high_rate);
+    ping->setMode(mode);
+    ping->setFamily(family);
+    ping->setPort(port);
+    ping->setSizeSweep(sweep_min, sweep_max, sweep_step);
+    ping->setMaxHops(max_hops);
+    ping->setLoad(load, num_flows);
+    ping->setIdleTime(idle_time);
+    ping->setLoadRate(load_rate);
+    ping->setLoadPort(load_port);
+    ping->setRecordFile(record_file);
+    session.close();
+    worker->start();
+
+    QStringList targets = worker->addresses();
+    logModel->setTargets(targets);
+    chart->clear();
+    setRows(targets);
 }
 
 void MainWindow::Impl::stop()
 {
-    if(ping->started()) {
-        ping->stop();
-        const QString text = QString("--- %1 ping statistics ---").arg(addressLine->text());
-        print(text);
-
-        const QString text2 = QString("%1 packets transmitted, %2 received, %3\% packet loss, ")
-            .arg(ping->transmittedPackets()).arg(ping->receivedPackets()).arg(ping->loss());
-        print(text2);
-
-        const QString text3 = QString("rtt min/avg/max/mdev = %1/%2/%3/%4 ms")
-            .arg(ping->min()).arg(ping->avg()).arg(ping->max()).arg(ping->mdev());
-        print(text3);
+    if(worker->started()) {
+        worker->stop();
+        apply(worker->takeDelta());
+        for(int i = 0; i < ping->numTargets(); ++i) {
+            if(ping->beyondDestination(i)) {
+                continue;
+            }
+            const RttStatistics& statistics = ping->statistics(i);
+            QString address = ping->address(i);
+            if(ping->hop(i) > 0) {
+                address += QString(" (%1)").arg(ping->responder(i).isEmpty() ? "???" : ping->responder(i));
+            }
+            const QString text = QString("--- %1 ping statistics ---").arg(address);
+            print(text);
+
+            const QString text2 = QString("%1 packets transmitted, %2 received, +%3 duplicates, %4 reordered, "
+                "%5 late, %6\% packet loss")
+                .arg(ping->transmittedPackets(i)).arg(ping->receivedPackets(i)).arg(ping->duplicatePackets(i))
+                .arg(ping->reorderedPackets(i)).arg(ping->latePackets(i)).arg(ping->loss(i));
+            print(text2);
+
+            const QString text3 = QString("rtt min/avg/max/mdev = %1/%2/%3/%4 ms")
+                .arg(statistics.min()).arg(statistics.avg()).arg(statistics.max()).arg(statistics.mdev());
+            print(text3);
+
+            const QString text4 = QString("rtt p50/p90/p99/p99.9 = %1/%2/%3/%4 ms")
+                .arg(statistics.percentile(50.0)).arg(statistics.percentile(90.0))
+                .arg(statistics.percentile(99.0)).arg(statistics.percentile(99.9));
+            print(text4);
+
+            const LossStatistics& losses = ping->lossStatistics(i);
+            quint64 long_runs = 0;
+            for(int j = 5; j <= LossStatistics::MaxRunLength; ++j) {
+                long_runs += losses.numRuns(j);
+            }
+            const QString text8 = QString("jitter = %1 ms, loss runs 1/2/3/4/5+ = %2/%3/%4/%5/%6, max run %7")
+                .arg(ping->jitter(i)).arg(losses.numRuns(1)).arg(losses.numRuns(2)).arg(losses.numRuns(3))
+                .arg(losses.numRuns(4)).arg(long_runs).arg(losses.maxRunLength());
+            print(text8);
+
+            const QString text9 = QString("%1 bursts, burst/gap density = %2/%3\%, burst/gap length = %4/%5 packets")
+                .arg(losses.numBursts()).arg(losses.burstDensity() * 100.0).arg(losses.gapDensity() * 100.0)
+                .arg(losses.meanBurstLength()).arg(losses.meanGapLength());
+            print(text9);
+
+            const QString text10 = QString("gilbert-elliott p/r/1-k/1-h = %1/%2/%3/%4")
+                .arg(losses.p()).arg(losses.r()).arg(1.0 - losses.k()).arg(1.0 - losses.h());
+            print(text10);
+
+            if(ping->mode() == Ping::Twamp && statistics.count() > 0) {
+                const RttStatistics& forward = ping->forwardStatistics(i);
+                const RttStatistics& reverse = ping->reverseStatistics(i);
+                const QString text5 = QString("forward min/avg/max/jitter = %1/%2/%3/%4 ms")
+                    .arg(forward.min()).arg(forward.avg()).arg(forward.max()).arg(ping->forwardJitter(i));
+                print(text5);
+
+                const QString text6 = QString("reverse min/avg/max/jitter = %1/%2/%3/%4 ms")
+                    .arg(reverse.min()).arg(reverse.avg()).arg(reverse.max()).arg(ping->reverseJitter(i));
+                print(text6);
+
+                const QString text7 = QString("clock offset = %1 ms").arg(ping->clockOffset(i));
+                print(text7);
+            }
+
+            const SizeStatistics& sizes = ping->sizeStatistics(i);
+            if(sizes.numSizes() > 0) {
+                const QString text12 = QString("size sweep %1-%2 bytes: slope = %3 ms/byte, bottleneck >= %4 Mbit/s")
+                    .arg(sizes.size(0)).arg(sizes.size(sizes.numSizes() - 1)).arg(sizes.slope())
+                    .arg(sizes.bottleneckRate());
+                print(text12);
+
+                QString text13 = QString("path mtu = %1, largest reply %2 bytes")
+                    .arg(sizes.pathMtu()).arg(sizes.largestReply());
+                if(sizes.reportedMtu() > 0) {
+                    text13 += QString(", fragmentation needed at %1").arg(sizes.reportedMtu());
+                }
+                print(text13);
+            }
+
+            const RttStatistics& idle = ping->idleStatistics(i);
+            const RttStatistics& loaded = ping->loadedStatistics(i);
+            if(ping->load() != Ping::NoLoad && idle.count() > 0 && loaded.count() > 0) {
+                const QString text11 = QString("idle/loaded p50 = %1/%2 ms, p99 = %3/%4 ms, inflation = %5 ms")
+                    .arg(idle.percentile(50.0)).arg(loaded.percentile(50.0))
+                    .arg(idle.percentile(99.0)).arg(loaded.percentile(99.0))
+                    .arg(loaded.percentile(50.0) - idle.percentile(50.0));
+                print(text11);
+            }
+        }
+
+        if(ping->family() == Ping::DualStack) {
+            // the same impairments seen over either family
+            for(Ping::Family family : { Ping::Ipv4, Ping::Ipv6 }) {
+                int transmitted = 0;
+                int lost = 0;
+                for(int i = 0; i < ping->numTargets(); ++i) {
+                    if(ping->targetFamily(i) == family) {
+                        transmitted += ping->transmittedPackets(i);
+                        lost += ping->lostPackets(i);
+                    }
+                }
+                const RttStatistics& statistics = ping->familyStatistics(family);
+                const QString text14 = QString("%1: %2 packets, %3% loss, rtt min/avg/max/p99 = %4/%5/%6/%7 ms")
+                    .arg(family == Ping::Ipv4 ? "IPv4" : "IPv6").arg(transmitted)
+                    .arg(transmitted > 0 ? (double)lost / (double)transmitted * 100.0 : 0.0)
+                    .arg(statistics.min()).arg(statistics.avg()).arg(statistics.max())
+                    .arg(statistics.percentile(99.0));
+                print(text14);
+            }
+        }
+
+        const LoadGenerator& generator = ping->loadGenerator();
+        for(int i = 0; i < generator.numFlows(); ++i) {
+            QString text = QString("flow %1 %2 %3: %4 bytes, %5 Mbit/s")
+                .arg(i).arg(generator.protocol(i) == LoadGenerator::Tcp ? "tcp" : "udp").arg(generator.address(i))
+                .arg(generator.bytes(i)).arg(generator.throughput(i));
+            if(!generator.error(i).isEmpty()) {
+                text += QString(" (%1)").arg(generator.error(i));
+            }
+            print(text);
+        }
     }
 }
 
@@ -139,16 +442,270 @@ void MainWindow::Impl::config()
     PingConfigDialog dialog(self);
     dialog.setCount(count);
     dialog.setWait(wait);
+    dialog.setTimeout(timeout);
+    dialog.setHighRate(is_high_rate);
+    dialog.setMode(mode);
+    dialog.setFamily(family);
+    dialog.setPort(port);
+    dialog.setSweepMin(sweep_min);
+    dialog.setSweepMax(sweep_max);
+    dialog.setSweepStep(sweep_step);
+    dialog.setMaxHops(max_hops);
+    dialog.setLoad(load);
+    dialog.setFlows(num_flows);
+    dialog.setIdleTime(idle_time);
+    dialog.setLoadRate(load_rate);
+    dialog.setLoadPort(load_port);
 
     if(dialog.exec()) {
         count = dialog.count();
         wait = dialog.wait();
+        timeout = dialog.timeout();
+        is_high_rate = dialog.highRate();
+        mode = dialog.mode();
+        family = dialog.family();
+        port = dialog.port();
+        sweep_min = dialog.sweepMin();
+        sweep_max = dialog.sweepMax();
+        sweep_step = dialog.sweepStep();
+        max_hops = dialog.maxHops();
+        load = dialog.load();
+        num_flows = dialog.flows();
+        idle_time = dialog.idleTime();
+        load_rate = dialog.loadRate();
+        load_port = dialog.loadPort();
     }
 }
 
 void MainWindow::Impl::print(const QString& text)
 {
-    messageText->append(text);
+    QScrollBar* scrollBar = logView->verticalScrollBar();
+    bool is_bottom = scrollBar->value() == scrollBar->maximum();
+    logModel->append(text);
+    if(is_bottom) {
+        logView->scrollToBottom();
+    }
+}
+
+void MainWindow::Impl::apply(const PingDelta& delta)
+{
+    QScrollBar* scrollBar = logView->verticalScrollBar();
+    bool is_bottom = scrollBar->value() == scrollBar->maximum();
+
+    // the samples between two lines go into the log as one burst
+    int position = 0;
+    for(int i = 0; i <= delta.lines.size(); ++i) {
+        int end = i < delta.lines.size() ? delta.line_positions[i] : delta.samples.size();
+        if(end > position) {
+            logModel->append(delta.samples.constData() + position, end - position);
+            position = end;
+        }
+        if(i < delta.lines.size()) {
+            logModel->append(delta.lines[i]);
+        }
+    }
+    if(delta.dropped > 0) {
+        logModel->append(QString("ping: %1 samples dropped by the display").arg(delta.dropped));
+    }
+    if(is_bottom && (!delta.samples.isEmpty() || !delta.lines.isEmpty() || delta.dropped > 0)) {
+        logView->scrollToBottom();
+    }
+
+    // the replies are binned by the worker, the chart only merges a few buckets per frame
+    chart->addBuckets(delta.chart_buckets);
+
+    // loss is binned from the cumulative counters once per frame rather than per packet
+    for(int i = 0; i < delta.indices.size(); ++i) {
+        setRow(delta.indices[i], delta.rows[i]);
+        if(delta.indices[i] == chart_target) {
+            chart->addCounts(delta.rows[i].transmitted, delta.rows[i].received);
+        }
+    }
+}
+
+void MainWindow::Impl::setRows(const QStringList& addresses)
+{
+    summaryTable->setRowCount(addresses.size());
+    for(int i = 0; i < addresses.size(); ++i) {
+        for(int j = 0; j < NumColumns; ++j) {
+            QTableWidgetItem* item = new QTableWidgetItem;
+            if(j != Address) {
+                item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            }
+            summaryTable->setItem(i, j, item);
+        }
+        summaryTable->item(i, Address)->setText(addresses[i]);
+        summaryTable->item(i, Address)->setData(Qt::UserRole, addresses[i]);
+        summaryTable->setRowHidden(i, false);
+    }
+}
+
+void MainWindow::Impl::setRow(const int& index, const PingRow& row)
+{
+    if(index >= summaryTable->rowCount() || !summaryTable->item(index, Address)) {
+        return;
+    }
+
+    // a hop shows the router that answered it and the hops behind the destination go away
+    if(!row.responder.isEmpty()) {
+        QTableWidgetItem* item = summaryTable->item(index, Address);
+        item->setText(QString("%1: %2").arg(item->data(Qt::UserRole).toString()).arg(row.responder));
+    }
+    summaryTable->setRowHidden(index, row.beyond);
+
+    summaryTable->item(index, Sent)->setText(QString::number(row.transmitted));
+    summaryTable->item(index, Received)->setText(QString::number(row.received));
+    summaryTable->item(index, Loss)->setText(QString::number(row.loss, 'f', 1));
+    summaryTable->item(index, Dup)->setText(QString::number(row.duplicates));
+    summaryTable->item(index, Reorder)->setText(QString::number(row.reordered));
+    summaryTable->item(index, Late)->setText(QString::number(row.late));
+    if(row.count > 0) {
+        summaryTable->item(index, Last)->setText(QString::number(row.last, 'f', 3));
+        summaryTable->item(index, Min)->setText(QString::number(row.min, 'f', 3));
+        summaryTable->item(index, Avg)->setText(QString::number(row.avg, 'f', 3));
+        summaryTable->item(index, Max)->setText(QString::number(row.max, 'f', 3));
+        summaryTable->item(index, Mdev)->setText(QString::number(row.mdev, 'f', 3));
+        summaryTable->item(index, P99)->setText(QString::number(row.p99, 'f', 3));
+    }
+}
+
+void MainWindow::Impl::setChartTarget(const int& index)
+{
+    if(index >= 0 && index != chart_target) {
+        chart_target = index;
+        worker->setChartTarget(index);
+        chart->clear();
+        if(session.isOpen()) {
+            replayChart();
+        }
+    }
+}
+
+void MainWindow::Impl::record(const bool& on)
+{
+    static QString dir = QDir::homePath();
+    QString fileName;
+    if(on) {
+        fileName = QFileDialog::getSaveFileName(self, "Record Session",
+            dir,
+            "Ping Sessions (*.pingsession);;All Files (*)");
+        if(fileName.isEmpty()) {
+            recordAct->setChecked(false);
+            return;
+        }
+        QFileInfo info(fileName);
+        dir = info.absolutePath();
+    }
+    // the file is written from the next start on
+    record_file = fileName;
+}
+
+void MainWindow::Impl::open()
+{
+    static QString dir = QDir::homePath();
+    QString fileName = QFileDialog::getOpenFileName(self, "Open Session",
+        dir,
+        "Ping Sessions (*.pingsession);;All Files (*)");
+
+    if(fileName.isEmpty()) {
+        return;
+    } else {
+        QFileInfo info(fileName);
+        dir = info.absolutePath();
+        stop();
+        if(session.open(fileName)) {
+            replay();
+        } else {
+            print(QString("%1: not a ping session").arg(fileName));
+        }
+    }
+}
+
+void MainWindow::Impl::replay()
+{
+    // the columns are read straight from the mapped file, nothing is parsed
+    int numTargets = session.numTargets();
+    QVector<RttStatistics> statistics(numTargets);
+    QVector<int> received(numTargets, 0);
+    QVector<int> duplicates(numTargets, 0);
+    QVector<int> reordered(numTargets, 0);
+    QVector<int> late(numTargets, 0);
+    QVector<double> last(numTargets, 0.0);
+    for(int b = 0; b < session.numBlocks(); ++b) {
+        const float* rtts = session.rtts(b);
+        const qint32* targets = session.targets(b);
+        const quint16* flags = session.flags(b);
+        for(int i = 0; i < session.blockSize(b); ++i) {
+            int index = targets[i];
+            if(index < 0 || index >= numTargets) {
+                continue;
+            }
+            if(flags[i] & PingSample::Duplicate) {
+                ++duplicates[index];
+                continue;
+            }
+            reordered[index] += (flags[i] & PingSample::Reordered) ? 1 : 0;
+            late[index] += (flags[i] & PingSample::Late) ? 1 : 0;
+            statistics[index].add(rtts[i]);
+            last[index] = rtts[i];
+            ++received[index];
+        }
+    }
+
+    QStringList addresses;
+    for(int i = 0; i < numTargets; ++i) {
+        addresses << session.address(i);
+    }
+    logModel->setTargets(addresses);
+    setRows(addresses);
+    for(int i = 0; i < numTargets; ++i) {
+        PingRow row;
+        row.transmitted = session.transmittedPackets(i);
+        row.received = received[i];
+        row.loss = row.transmitted > 0 ? (double)session.lostPackets(i) / (double)row.transmitted * 100.0 : 0.0;
+        row.duplicates = duplicates[i];
+        row.reordered = reordered[i];
+        row.late = late[i];
+        row.last = last[i];
+        row.setStatistics(statistics[i]);
+        row.beyond = false;
+        setRow(i, row);
+    }
+
+    print(QString("--- session of %1: %2 targets, %3 samples%4 ---")
+        .arg(QDateTime::fromMSecsSinceEpoch(session.startTime() / 1000).toString("yyyy-MM-dd hh:mm:ss"))
+        .arg(numTargets).arg(session.numSamples()).arg(session.isComplete() ? "" : ", cut off"));
+
+    chart_target = 0;
+    worker->setChartTarget(0);
+    chart->clear();
+    replayChart();
+}
+
+void MainWindow::Impl::replayChart()
+{
+    if(chart_target >= session.numTargets()) {
+        return;
+    }
+    for(int b = 0; b < session.numBlocks(); ++b) {
+        const qint32* targets = session.targets(b);
+        const quint16* flags = session.flags(b);
+        for(int i = 0; i < session.blockSize(b); ++i) {
+            if(targets[i] == chart_target && !(flags[i] & PingSample::Duplicate)) {
+                PingSample sample;
+                sample.time = session.times(b)[i];
+                sample.rtt = session.rtts(b)[i];
+                sample.target = targets[i];
+                sample.sequence = session.sequences(b)[i];
+                sample.flags = flags[i];
+                sample.ttl = session.ttls(b)[i];
+                sample.bytes = session.bytes(b)[i];
+                sample.forward = session.forwards(b)[i];
+                sample.reverse = session.reverses(b)[i];
+                chart->addSample(sample);
+            }
+        }
+    }
 }
 
 void MainWindow::Impl::createActions()
@@ -167,18 +724,32 @@ void MainWindow::Impl::createActions()
     configAct = new QAction(configIcon, "&Config", self);
     configAct->setStatusTip("Show the config dialog");
     self->connect(configAct, &QAction::triggered, [&](){ config(); });
+
+    const QIcon recordIcon = QIcon::fromTheme("media-record");
+    recordAct = new QAction(recordIcon, "&Record", self);
+    recordAct->setCheckable(true);
+    recordAct->setStatusTip("Record the next runs to a session file");
+    self->connect(recordAct, &QAction::toggled, [&](bool checked){ record(checked); });
+
+    const QIcon openIcon = QIcon::fromTheme("document-open");
+    openAct = new QAction(openIcon, "&Open", self);
+    openAct->setStatusTip("Replay a recorded session");
+    self->connect(openAct, &QAction::triggered, [&](){ open(); });
 }
 
 void MainWindow::Impl::createToolBars()
 {
     QToolBar* pingToolBar = self->addToolBar("Ping");
     addressLine = new QLineEdit;
-    addressLine->setPlaceholderText("xxx.xxx.xxx.xxx");
+    addressLine->setPlaceholderText("xxx.xxx.xxx.xxx, xxxx::x, host or xxx.xxx.xxx.xxx/xx");
+    addressLine->setToolTip("Hosts separated by commas or spaces, or a CIDR range");
 
     pingToolBar->addWidget(addressLine);
     pingToolBar->addAction(startAct);
     pingToolBar->addAction(stopAct);
     pingToolBar->addAction(configAct);
+    pingToolBar->addAction(recordAct);
+    pingToolBar->addAction(openAct);
 }
 
 PingConfigDialog::PingConfigDialog(QWidget* parent)
@@ -188,10 +759,93 @@ PingConfigDialog::PingConfigDialog(QWidget* parent)
     countSpin->setRange(0, 9999);
 
     waitSpin = new QDoubleSpinBox;
+    waitSpin->setDecimals(3);
+
+    timeoutSpin = new QDoubleSpinBox;
+    timeoutSpin->setDecimals(3);
+    timeoutSpin->setRange(0.001, 60.0);
+    timeoutSpin->setToolTip("Unanswered probes count as lost after the timeout, later replies as late");
+
+    highRateCheck = new QCheckBox;
+    highRateCheck->setToolTip("Allow waits below 0.2 s and use kernel timestamps");
+
+    modeCombo = new QComboBox;
+    for(const char* label : modeLabels) {
+        modeCombo->addItem(label);
+    }
+
+    familyCombo = new QComboBox;
+    for(const char* label : familyLabels) {
+        familyCombo->addItem(label);
+    }
+    familyCombo->setToolTip("Dual stack probes every name over IPv4 and IPv6 as targets of their own");
+
+    portSpin = new QSpinBox;
+    portSpin->setRange(0, 65535);
+    portSpin->setSpecialValueText("Default");
+    portSpin->setToolTip("11311 for TCP connect, 10007 for UDP echo and 10862 for TWAMP light by default, "
+        "the well-known 7 and 862 work as well");
+    connect(modeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+        [&](int index){ portSpin->setEnabled(index != Ping::Icmp); });
+    portSpin->setEnabled(false);
+
+    sweepMinSpin = new QSpinBox;
+    sweepMinSpin->setRange(0, 9000);
+
+    sweepMaxSpin = new QSpinBox;
+    sweepMaxSpin->setRange(0, 9000);
+    sweepMaxSpin->setSpecialValueText("Off");
+    sweepMaxSpin->setToolTip("Cycle the IP packet size of ICMP and UDP echo probes with DF set");
+
+    sweepStepSpin = new QSpinBox;
+    sweepStepSpin->setRange(1, 9000);
+
+    hopsSpin = new QSpinBox;
+    hopsSpin->setRange(0, 64);
+    hopsSpin->setSpecialValueText("Off");
+    hopsSpin->setToolTip("Probe every hop up to this TTL in parallel, ICMP echo only");
+
+    loadCombo = new QComboBox;
+    for(const char* label : loadLabels) {
+        loadCombo->addItem(label);
+    }
+    loadCombo->setToolTip("Run bulk flows to rqt_ping_sink on the targets after the idle time");
+
+    flowsSpin = new QSpinBox;
+    flowsSpin->setRange(1, 64);
+
+    idleSpin = new QDoubleSpinBox;
+    idleSpin->setDecimals(1);
+    idleSpin->setRange(0.0, 3600.0);
+    idleSpin->setToolTip("Probing time before the load starts, the baseline for the inflation");
+
+    rateSpin = new QDoubleSpinBox;
+    rateSpin->setDecimals(1);
+    rateSpin->setRange(0.1, 10000.0);
+    rateSpin->setToolTip("Rate of each UDP flow, TCP flows are not paced");
+
+    sinkPortSpin = new QSpinBox;
+    sinkPortSpin->setRange(0, 65535);
+    sinkPortSpin->setSpecialValueText("Default");
+    sinkPortSpin->setToolTip("10009 (rqt_ping_sink) by default, 9 for a discard service");
 
     QFormLayout* layout = new QFormLayout;
     layout->addRow("Count [-]", countSpin);
     layout->addRow("Wait [s]", waitSpin);
+    layout->addRow("Timeout [s]", timeoutSpin);
+    layout->addRow("High rate", highRateCheck);
+    layout->addRow("Mode", modeCombo);
+    layout->addRow("Family", familyCombo);
+    layout->addRow("Port", portSpin);
+    layout->addRow("Sweep from [bytes]", sweepMinSpin);
+    layout->addRow("Sweep to [bytes]", sweepMaxSpin);
+    layout->addRow("Sweep step [bytes]", sweepStepSpin);
+    layout->addRow("Hops [-]", hopsSpin);
+    layout->addRow("Load", loadCombo);
+    layout->addRow("Flows [-]", flowsSpin);
+    layout->addRow("Idle [s]", idleSpin);
+    layout->addRow("UDP rate [Mbit/s]", rateSpin);
+    layout->addRow("Sink port", sinkPortSpin);
 
     buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok
                                      | QDialogButtonBox::Cancel);
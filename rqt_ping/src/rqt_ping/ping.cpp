@@ -6,44 +6,344 @@
 
 #include <QByteArray>
 #include <QProcess>
-#include <QStringList>
+#include <QProcessEnvironment>
+#include <QRegularExpression>
+#include <QTimer>
 #include <QVector>
-#include <QtMath>
 
-#include <algorithm>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <netdb.h>
+#include <netinet/icmp6.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "rqt_ping/load_generator.h"
+#include "rqt_ping/loss_statistics.h"
+#include "rqt_ping/ping_output_parser.h"
+#include "rqt_ping/sequence_tracker.h"
+#include "rqt_ping/session_writer.h"
+#include "rqt_ping/shm_stats_writer.h"
+#include "rqt_ping/size_statistics.h"
+#include "rqt_ping/socket_set.h"
+#include "rqt_ping/timer_wheel.h"
+#include "rqt_ping/twamp_packet.h"
+
+namespace {
+
+const int DataLength = 56;
+const int PacketLength = sizeof(struct icmphdr) + DataLength;
+// every target holds three RttStatistics histograms of about 4 KB and its trackers, so
+// a range is capped at a /20 (some 60 MB) instead of a /16 (about 1 GB)
+const int MaxCidrHosts = 4096;
+const double MinWait = 0.2;
+const double MinHighRateWait = 0.001;
+const int TxRingSize = 4096;
+const int DefaultTcpPort = 11311;
+// the bundled reflectors and the sink listen above 1024 so that they run without root,
+// the well-known ports (7 echo, 9 discard) are set like any other
+const int DefaultEchoPort = 10007;
+const int MaxConnects = 1024;
+const double DefaultTimeout = 2.0;
+const int MaxWindowSize = 4096;
+const int DefaultSinkPort = 10009;
+const int OffsetWindow = 256;
+const int SnapshotInterval = 100;
+const int BatchSize = 64;
+// replies of the size sweep may be jumbo frames
+const int ReceiveLength = 9216;
+const int ControlLength = 256;
+const int MaxSweepSize = 9000;
+const int IpHeaderLength = 20;
+const int Ipv6HeaderLength = 40;
+const int UdpHeaderLength = 8;
+const int MaxHops = 64;
+// every wire sequence of the per-hop mode
+const int HopRecords = 65536;
+
+// the sweep pads the probes with zeros, which leave the checksum alone
+char zeros[MaxSweepSize];
+
+quint16 identifierCount = 0;
+
+// what a name resolved to
+enum { FoundIpv4 = 1, FoundIpv6 = 2 };
+
+struct Payload {
+    qint64 sent;
+    quint32 index;
+};
+
+quint32 partialSum(const void* data, int length, quint32 sum = 0)
+{
+    const quint16* p = (const quint16*)data;
+    while(length > 1) {
+        sum += *p++;
+        length -= 2;
+    }
+    if(length == 1) {
+        sum += *(const quint8*)p;
+    }
+    return sum;
+}
+
+quint16 foldSum(quint32 sum)
+{
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum += (sum >> 16);
+    return (quint16)~sum;
+}
+
+qint64 nanoseconds(const struct timespec& ts)
+{
+    return (qint64)ts.tv_sec * 1000000000LL + (qint64)ts.tv_nsec;
+}
+
+qint64 now(const clockid_t& clock = CLOCK_MONOTONIC)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return nanoseconds(ts);
+}
+
+int socketError(const int& fd)
+{
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if(getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0) {
+        return errno;
+    }
+    return error;
+}
+
+QString numericHost(const struct sockaddr* addr)
+{
+    char host[INET6_ADDRSTRLEN];
+    if(addr->sa_family == AF_INET6) {
+        inet_ntop(AF_INET6, &((const struct sockaddr_in6*)addr)->sin6_addr, host, sizeof(host));
+    } else {
+        inet_ntop(AF_INET, &((const struct sockaddr_in*)addr)->sin_addr, host, sizeof(host));
+    }
+    return QString(host);
+}
+
+}
 
 namespace rqt_ping {
 
+struct PingTarget {
+    QString address;
+    int family;     // AF_INET or AF_INET6, the address of the other family is unused
+    struct sockaddr_in addr;
+    struct sockaddr_in6 addr6;
+    quint16 sequence;
+    qint64 due;
+    int transmitted_packets;
+    int received_packets;
+    double last_rtt;
+    double jitter;
+    RttStatistics statistics;
+    LossStatistics losses;
+
+    // one-way delays of the TWAMP mode
+    RttStatistics forward_statistics;
+    RttStatistics reverse_statistics;
+    double forward_jitter;
+    double reverse_jitter;
+    double last_forward;
+    double last_reverse;
+    qint64 clock_offset;
+    qint64 offset_rtt;
+    int offset_age;
+
+    // send times and the fate of the probes in flight
+    SequenceTracker tracker;
+
+    // minimum rtt per packet size and the path MTU of the sweep
+    SizeStatistics sizes;
+
+    // per-hop mode: the TTL of the probes, 0 outside it, and the first hop of the same
+    // destination, which keeps the hop count of the destination once that answered
+    int hop;
+    int first_hop;
+    int distance;
+    bool is_parked;
+    struct sockaddr_storage responder;
+};
+
+struct TxRecord {
+    int index;
+    quint16 sequence;
+};
+
+// the probe socket of one address family, the kernel numbers the transmit timestamps per socket
+struct PingSocket {
+    int fd;
+    int family;
+    bool is_raw;
+    quint32 tx_counter;
+    std::vector<TxRecord> tx_records;
+};
+
+// a TCP handshake in flight
+struct TcpProbe {
+    int fd;
+    int index;
+    quint16 sequence;
+    qint64 sent;
+};
+
+// preallocated messages of the batched send and receive paths,
+// the IPv4 probes fill the messages from the front and the IPv6 ones from the back,
+// so each family goes out on its own socket with one sendmmsg
+struct PacketBatch {
+    char tx_packets[BatchSize][PacketLength];
+    struct iovec tx_iovs[BatchSize][2];
+    struct mmsghdr tx_msgs[BatchSize];
+    char tx_controls[BatchSize][CMSG_SPACE(sizeof(int))];
+    int tx_indices[BatchSize];
+    int num_pending;
+    int num_pending6;
+
+    char rx_packets[BatchSize][ReceiveLength];
+    char rx_controls[BatchSize][ControlLength];
+    struct sockaddr_storage rx_from[BatchSize];
+    struct iovec rx_iovs[BatchSize];
+    struct mmsghdr rx_msgs[BatchSize];
+};
+
+// fallback for hosts where neither ICMP socket type may be opened
+struct PingProcess {
+    QProcess process;
+    PingOutputParser parser;
+    int index;
+};
+
 class Ping::Impl
 {
 public:
     Ping* self;
 
     Impl(Ping* self);
+    ~Impl();
 
     void start();
     void close();
-    void write();
+    void addTarget(const QString& address, const int& family, const struct sockaddr_in& addr,
+        const struct sockaddr_in6& addr6);
+    bool openSockets();
+    bool openSocket(PingSocket& sock);
+    void startProcesses();
+    void stopProcesses();
+    void readProcess(PingProcess* process);
+    void addReply(const int& index, const PingReply& reply);
+    void closeSocket();
+    int resolve(const QString& address, struct sockaddr_in& addr, struct sockaddr_in6& addr6);
+    const struct sockaddr* targetAddress(const PingTarget& target) const;
+    socklen_t targetAddressLength(const PingTarget& target) const;
+    bool matches(const PingTarget& target, const struct sockaddr_storage& from) const;
+    void enableTimestamps();
+    void initializeBatch();
 
-    void on_process_finished(const int& exitCode, QProcess::ExitStatus exitStatus);
-    void on_process_readyReadStandardError();
-    void on_process_readyReadStandardOutput();
-    void on_process_stateChanged(QProcess::ProcessState newState);
+    qint64 interval() const;
+    qint64 timeoutInterval() const;
+    void schedule();
+    void addProbe(const int& index, const quint16& sequence, const qint64& sent);
+    void expireProbes(const qint64& time);
+    void updateLoss();
+    void send(const int& index);
+    void flush();
+    void flush(PingSocket& sock, const int& first, const int& count);
+    void connectTarget(const int& index);
+    void finishConnect(const int& sock, const int& error);
+    void expireConnects(const qint64& time);
+    void closeConnect(const int& position);
+    void receive(PingSocket& sock);
+    void receiveReply(const PingSocket& sock, const char* data, ssize_t length, struct msghdr& msg,
+        const struct sockaddr_storage& from, qint64 time);
+    void receiveTwamp(const char* data, const int& length, const struct sockaddr_storage& from,
+        const qint64& time, const int& ttl);
+    qint64 transmitTime(const PingTarget& target, const quint16& sequence, const qint64& sent) const;
+    int headerLength(const int& family) const;
+    void receiveErrors(PingSocket& sock);
+    void receiveHop(const PingSocket& sock, const char* data, const ssize_t& length,
+        const struct sockaddr_storage& destination, const struct sock_extended_err* error, const qint64& time);
+    void updateHop(const int& index, const struct sockaddr* responder, const bool& isDestination);
+    bool isBeyond(const int& index) const;
+    void addSample(const PingSample& sample);
 
-    QProcess process;
-    QString address;
-    QVector<double> times;
+    void startLoad();
+    void publishSnapshot();
+    void setStatistics(ShmStats& stats, const RttStatistics& statistics) const;
+
+    void on_sendTimer_timeout();
 
+    QStringList addresses;
+    QVector<PingTarget> targets;
+    RttStatistics statistics;
+    RttStatistics statistics4;
+    RttStatistics statistics6;
+    SocketSet sockets;
+    TimerWheel wheel;
+    TimerWheel timeouts;
+    QTimer sendTimer;
+    LoadGenerator load_generator;
+    QTimer loadTimer;
+    QVector<RttStatistics> idle_statistics;
+    QVector<RttStatistics> loaded_statistics;
+    ShmStatsWriter shm;
+    QString shm_name;
+    QTimer snapshotTimer;
+    SessionWriter recorder;
+    QString record_file;
+    QVector<PingProcess*> processes;
+    std::vector<int> expired;
+    std::vector<TcpProbe> connects;
+    std::vector<TxRecord> hop_records;
+    quint16 hop_sequence;
+    PacketBatch batch;
+    quint32 template_sum;
+
+    Mode mode;
+    Family family;
+    int port;
+    int sweep_min;
+    int sweep_max;
+    int sweep_step;
+    bool is_sweeping;
+    int max_hops;
+    bool is_tracing;
+    Load load;
+    int num_flows;
+    int load_port;
+    double idle_time;
+    bool is_loaded;
+    PingSocket socket4;
+    PingSocket socket6;
+    quint16 identifier;
     int count;
     double second;
+    double timeout;
+    int window_size;
+    bool is_high_rate;
+    bool has_timestamps;
+    clockid_t clock;
     bool is_started;
-    double min;
-    double avg;
-    double max;
-    double mdev;
     double loss;
     int transmitted_packets;
     int received_packets;
+    int lost_packets;
 };
 
 
@@ -54,25 +354,56 @@ Ping::Ping(QObject* parent)
 }
 
 Ping::Impl::Impl(Ping* self)
-    : self(self)
+    : self(self),
+      load_generator(&sockets)
 {
+    mode = Icmp;
+    family = AnyFamily;
+    port = 0;
+    sweep_min = 0;
+    sweep_max = 0;
+    sweep_step = 64;
+    is_sweeping = false;
+    max_hops = 0;
+    is_tracing = false;
+    hop_sequence = 0;
+    load = NoLoad;
+    num_flows = 1;
+    load_port = 0;
+    idle_time = 5.0;
+    is_loaded = false;
+    socket4.fd = -1;
+    socket4.family = AF_INET;
+    socket4.is_raw = false;
+    socket4.tx_counter = 0;
+    socket4.tx_records.resize(TxRingSize);
+    socket6.fd = -1;
+    socket6.family = AF_INET6;
+    socket6.is_raw = false;
+    socket6.tx_counter = 0;
+    socket6.tx_records.resize(TxRingSize);
+    identifier = (quint16)(getpid() + identifierCount++);
     count = 0;
     second = 1.0;
+    timeout = DefaultTimeout;
+    window_size = 0;
+    is_high_rate = false;
+    has_timestamps = false;
+    clock = CLOCK_MONOTONIC;
     is_started = false;
-    times.clear();
-    min = 0.0;
-    avg = 0.0;
-    max = 0.0;
-    mdev = 0.0;
     loss = 0.0;
     transmitted_packets = 0;
     received_packets = 0;
+    lost_packets = 0;
+
+    sendTimer.setSingleShot(true);
+    sendTimer.setTimerType(Qt::PreciseTimer);
+    self->connect(&sendTimer, &QTimer::timeout, [&](){ on_sendTimer_timeout(); });
 
-    self->connect(&process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-        [=](int exitCode, QProcess::ExitStatus exitStatus){ on_process_finished(exitCode, exitStatus); });
-    self->connect(&process, &QProcess::readyReadStandardError, [&](){ on_process_readyReadStandardError(); });
-    self->connect(&process, &QProcess::readyReadStandardOutput, [&](){ on_process_readyReadStandardOutput(); });
-    self->connect(&process, &QProcess::stateChanged, [&](QProcess::ProcessState newState){ on_process_stateChanged(newState); });
+    loadTimer.setSingleShot(true);
+    self->connect(&loadTimer, &QTimer::timeout, [&](){ startLoad(); });
+
+    self->connect(&snapshotTimer, &QTimer::timeout, [&](){ publishSnapshot(); });
 }
 
 Ping::~Ping()
@@ -80,9 +411,19 @@ Ping::~Ping()
     delete impl;
 }
 
+Ping::Impl::~Impl()
+{
+    closeSocket();
+}
+
 void Ping::setAddress(const QString& address)
 {
-    impl->address = address;
+    impl->addresses = QStringList() << address;
+}
+
+void Ping::setAddresses(const QStringList& addresses)
+{
+    impl->addresses = addresses;
 }
 
 void Ping::setCount(const int& count)
@@ -92,11 +433,151 @@ void Ping::setCount(const int& count)
 
 void Ping::setWait(const double& second)
 {
-    if(second >= 0.2) {
+    if(second >= MinHighRateWait) {
         impl->second = second;
     }
 }
 
+void Ping::setHighRate(const bool& on)
+{
+    impl->is_high_rate = on;
+}
+
+bool Ping::highRate() const
+{
+    return impl->is_high_rate;
+}
+
+void Ping::setTimeout(const double& second)
+{
+    if(second > 0.0) {
+        impl->timeout = second;
+    }
+}
+
+double Ping::timeout() const
+{
+    return impl->timeout;
+}
+
+void Ping::setLoad(const Load& load, const int& numFlows)
+{
+    impl->load = load;
+    impl->num_flows = qMax(1, numFlows);
+}
+
+Ping::Load Ping::load() const
+{
+    return impl->load;
+}
+
+int Ping::numLoadFlows() const
+{
+    return impl->num_flows;
+}
+
+void Ping::setLoadPort(const int& port)
+{
+    impl->load_port = port;
+}
+
+void Ping::setLoadRate(const double& mbps)
+{
+    impl->load_generator.setUdpRate(mbps);
+}
+
+void Ping::setIdleTime(const double& second)
+{
+    if(second >= 0.0) {
+        impl->idle_time = second;
+    }
+}
+
+bool Ping::isLoaded() const
+{
+    return impl->is_loaded;
+}
+
+const LoadGenerator& Ping::loadGenerator() const
+{
+    return impl->load_generator;
+}
+
+void Ping::setMode(const Mode& mode)
+{
+    impl->mode = mode;
+}
+
+Ping::Mode Ping::mode() const
+{
+    return impl->mode;
+}
+
+void Ping::setFamily(const Family& family)
+{
+    impl->family = family;
+}
+
+Ping::Family Ping::family() const
+{
+    return impl->family;
+}
+
+void Ping::setSizeSweep(const int& minSize, const int& maxSize, const int& step)
+{
+    impl->sweep_min = minSize;
+    impl->sweep_max = qMin(maxSize, MaxSweepSize);
+    impl->sweep_step = qMax(1, step);
+}
+
+bool Ping::sizeSweep() const
+{
+    return impl->sweep_max > 0;
+}
+
+void Ping::setMaxHops(const int& hops)
+{
+    impl->max_hops = qBound(0, hops, MaxHops);
+}
+
+int Ping::maxHops() const
+{
+    return impl->max_hops;
+}
+
+void Ping::setSharedMemory(const QString& name)
+{
+    impl->shm_name = name;
+    if(name.isEmpty()) {
+        impl->shm.close();
+    }
+}
+
+QString Ping::sharedMemory() const
+{
+    return impl->shm_name;
+}
+
+void Ping::setRecordFile(const QString& fileName)
+{
+    impl->record_file = fileName;
+}
+
+QString Ping::recordFile() const
+{
+    return impl->record_file;
+}
+
+void Ping::setPort(const int& port)
+{
+    impl->port = port;
+}
+
+int Ping::port() const
+{
+    return impl->port;
+}
+
 void Ping::start()
 {
     impl->start();
@@ -104,16 +585,220 @@ void Ping::start()
 
 void Ping::Impl::start()
 {
+    close();
+
     is_started = true;
-    times.clear();
-    min = 0.0;
-    avg = 0.0;
-    max = 0.0;
-    mdev = 0.0;
+    statistics.clear();
+    statistics4.clear();
+    statistics6.clear();
+    targets.clear();
+    idle_statistics.clear();
+    loaded_statistics.clear();
+    load_generator.clear();
+    is_loaded = false;
+    is_tracing = max_hops > 0 && mode == Icmp;
+    if(max_hops > 0 && !is_tracing) {
+        emit self->output("ping: the per-hop mode needs ICMP echo, probing the destinations only");
+    }
+    if(second < MinWait && !is_high_rate) {
+        emit self->output(QString("ping: an interval of %1 s needs the high rate mode, using %2 s")
+            .arg(second).arg(MinWait));
+    }
+    is_sweeping = sweep_max > 0 && (mode == Icmp || mode == UdpEcho) && !is_tracing;
+    if(is_tracing) {
+        TxRecord record = { -1, 0 };
+        hop_records.assign(HopRecords, record);
+        hop_sequence = 0;
+    }
     loss = 0.0;
     transmitted_packets = 0;
     received_packets = 0;
-    process.start("bash");
+    lost_packets = 0;
+
+    // every probe that may still be answered needs a slot of the sequence window
+    qint64 in_flight = timeoutInterval() / interval() + 2;
+    window_size = (int)qMin((qint64)MaxWindowSize, in_flight * 2);
+    timeouts.clear(now());
+
+    for(int i = 0; i < addresses.size(); ++i) {
+        const QString& address = addresses.at(i);
+        if(address.isEmpty()) {
+            continue;
+        }
+        // what is left of a prefix after expandAddresses() is not a range that is probed
+        if(address.contains('/')) {
+            emit self->output(QString("ping: %1: not an address or a range of at most %2 hosts")
+                .arg(address).arg(MaxCidrHosts));
+            continue;
+        }
+        struct sockaddr_in addr;
+        struct sockaddr_in6 addr6;
+        int found = resolve(address, addr, addr6);
+        if(found == 0) {
+            continue;
+        }
+
+        // a name with addresses of both families is probed over IPv4 unless asked otherwise
+        bool use4 = (found & FoundIpv4) && family != Ipv6;
+        bool use6 = (found & FoundIpv6)
+            && (family == Ipv6 || family == DualStack || (family == AnyFamily && !use4));
+        if(!use4 && !use6) {
+            emit self->output(QString("ping: %1: No %2 address").arg(address).arg(family == Ipv6 ? "IPv6" : "IPv4"));
+            continue;
+        }
+        if(use4) {
+            addTarget(family == DualStack ? address + " (IPv4)" : address, AF_INET, addr, addr6);
+        }
+        if(use6) {
+            addTarget(family == DualStack ? address + " (IPv6)" : address, AF_INET6, addr, addr6);
+        }
+    }
+
+    if(targets.isEmpty()) {
+        // nothing is probed, so nothing is running either
+        is_started = false;
+        emit self->output("ping: no target");
+        return;
+    }
+    // the vector keeps its storage from here on
+    for(int i = 0; i < targets.size(); ++i) {
+        LossStatistics* losses = &targets[i].losses;
+        targets[i].tracker.setOutcomeFunction([losses](const bool& received){ losses->add(received); });
+    }
+
+    if(!record_file.isEmpty()) {
+        QStringList names;
+        for(int i = 0; i < targets.size(); ++i) {
+            names << targets[i].address;
+        }
+        if(!recorder.open(record_file, names, mode)) {
+            emit self->output(QString("ping: %1: %2").arg(record_file).arg(recorder.errorString()));
+        }
+    }
+
+    if(!shm_name.isEmpty()) {
+        if(shm.name() != shm_name && !shm.open(shm_name)) {
+            if(errno == EEXIST) {
+                emit self->output(QString("ping: shm_open %1: in use by another engine, or left behind by one "
+                    "(remove /dev/shm%1)").arg(shm_name));
+            } else {
+                emit self->output(QString("ping: shm_open %1: %2").arg(shm_name).arg(strerror(errno)));
+            }
+        }
+        if(shm.isOpen()) {
+            QStringList names;
+            for(int i = 0; i < targets.size(); ++i) {
+                names << targets[i].address;
+            }
+            shm.reset(names);
+            snapshotTimer.start(SnapshotInterval);
+        }
+    }
+    if(!openSockets()) {
+        if(mode == Icmp) {
+            startProcesses();
+        }
+        return;
+    }
+
+    int destination = port;
+    if(destination <= 0) {
+        destination = mode == TcpConnect ? DefaultTcpPort : (mode == Twamp ? DefaultTwampPort : DefaultEchoPort);
+    }
+    for(int i = 0; i < targets.size(); ++i) {
+        QString host = numericHost(targetAddress(targets[i]));
+        if(is_sweeping) {
+            const SizeStatistics& sizes = targets[i].sizes;
+            emit self->output(QString("%1 %2 (%3) %4-%5 bytes in %6 steps, DF set.")
+                .arg(mode == UdpEcho ? "UDP PMTU" : "PMTU").arg(targets[i].address).arg(host)
+                .arg(sizes.size(0)).arg(sizes.size(sizes.numSizes() - 1)).arg(sizes.numSizes()));
+        } else if(is_tracing) {
+            if(targets[i].hop == 1) {
+                emit self->output(QString("HOPS %1 (%2) %3 hops max, %4(%5) byte packets.")
+                    .arg(targets[i].address.left(targets[i].address.lastIndexOf(" hop "))).arg(host).arg(max_hops)
+                    .arg(DataLength).arg(PacketLength + headerLength(targets[i].family)));
+            }
+        } else if(mode == Icmp) {
+            emit self->output(QString("PING %1 (%2) %3(%4) bytes of data.")
+                .arg(targets[i].address).arg(host).arg(DataLength).arg(PacketLength + headerLength(targets[i].family)));
+        } else if(mode == TcpConnect) {
+            emit self->output(QString("TCP PING %1 (%2) port %3.").arg(targets[i].address).arg(host).arg(destination));
+        } else if(mode == Twamp) {
+            emit self->output(QString("TWAMP PING %1 (%2) port %3 %4 bytes of data.")
+                .arg(targets[i].address).arg(host).arg(destination).arg(TwampPacketLength));
+        } else {
+            emit self->output(QString("UDP PING %1 (%2) port %3 %4 bytes of data.")
+                .arg(targets[i].address).arg(host).arg(destination).arg(PacketLength));
+        }
+        targets[i].addr.sin_port = htons((quint16)destination);
+        targets[i].addr6.sin6_port = htons((quint16)destination);
+    }
+
+    // stagger the first probes evenly over one interval
+    qint64 period = interval();
+    qint64 base = now();
+    wheel.clear(base);
+    for(int i = 0; i < targets.size(); ++i) {
+        targets[i].due = base + period * i / targets.size();
+        wheel.schedule(i, targets[i].due);
+    }
+    on_sendTimer_timeout();
+
+    if(load != NoLoad) {
+        idle_statistics.fill(RttStatistics(), targets.size());
+        loaded_statistics.fill(RttStatistics(), targets.size());
+        loadTimer.start((int)(idle_time * 1000.0));
+    }
+}
+
+void Ping::Impl::addTarget(const QString& address, const int& family, const struct sockaddr_in& addr,
+    const struct sockaddr_in6& addr6)
+{
+    // the per-hop mode probes every hop as a target of its own, the index of the target
+    // has to fit the upper half of the timeout ids
+    int num_hops = is_tracing ? max_hops : 1;
+    if(targets.size() + num_hops > MaxCidrHosts) {
+        emit self->output(QString("ping: %1: too many targets").arg(address));
+        return;
+    }
+
+    PingTarget target;
+    target.address = address;
+    target.family = family;
+    target.addr = addr;
+    target.addr6 = addr6;
+    target.sequence = 0;
+    target.due = 0;
+    target.transmitted_packets = 0;
+    target.received_packets = 0;
+    target.last_rtt = 0.0;
+    target.jitter = 0.0;
+    target.forward_jitter = 0.0;
+    target.reverse_jitter = 0.0;
+    target.last_forward = 0.0;
+    target.last_reverse = 0.0;
+    target.clock_offset = 0;
+    target.offset_rtt = 0;
+    target.offset_age = OffsetWindow;
+    target.tracker.setWindowSize(window_size);
+    if(is_sweeping) {
+        int smallest = PacketLength + headerLength(family);
+        target.sizes.setRange(qMax(sweep_min, smallest), qMax(sweep_max, smallest), sweep_step);
+    }
+    target.hop = 0;
+    target.first_hop = targets.size();
+    target.distance = 0;
+    target.is_parked = false;
+    memset(&target.responder, 0, sizeof(target.responder));
+    if(!is_tracing) {
+        targets.push_back(target);
+        return;
+    }
+    for(int hop = 1; hop <= num_hops; ++hop) {
+        target.address = QString("%1 hop %2").arg(address).arg(hop);
+        target.hop = hop;
+        targets.push_back(target);
+    }
 }
 
 void Ping::stop()
@@ -123,133 +808,1400 @@ void Ping::stop()
 
 void Ping::Impl::close()
 {
+    // probes still unanswered are lost, as with the summary of the ping command
+    if(is_started) {
+        for(int i = 0; i < targets.size(); ++i) {
+            SequenceTracker& tracker = targets[i].tracker;
+            lost_packets -= tracker.lost();
+            tracker.finish();
+            lost_packets += tracker.lost();
+        }
+        updateLoss();
+    }
+
+    if(recorder.isOpen()) {
+        for(int i = 0; i < targets.size(); ++i) {
+            recorder.setCounts(i, targets[i].transmitted_packets, targets[i].tracker.lost());
+        }
+        if(!recorder.close()) {
+            emit self->output(QString("ping: %1: %2").arg(record_file).arg(recorder.errorString()));
+        }
+    }
+
     is_started = false;
-    process.close();
+    if(snapshotTimer.isActive()) {
+        snapshotTimer.stop();
+        publishSnapshot();
+    }
+    sendTimer.stop();
+    loadTimer.stop();
+    load_generator.stop();
+    wheel.clear();
+    timeouts.clear();
+    while(!connects.empty()) {
+        closeConnect((int)connects.size() - 1);
+    }
+    closeSocket();
+    stopProcesses();
 }
 
-double Ping::min() const
+void Ping::Impl::startProcesses()
 {
-    return impl->min;
+    emit self->output("ping: falling back to the ping command");
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("LANG", "C");
+
+    for(int i = 0; i < targets.size(); ++i) {
+        PingProcess* process = new PingProcess;
+        process->index = i;
+        process->parser.setReplyFunction([=](const PingReply& reply){ addReply(process->index, reply); });
+        process->parser.setMessageFunction([=](const char* line, int length){
+            emit self->output(QString::fromLocal8Bit(line, length));
+        });
+        processes.push_back(process);
+
+        // the numeric address keeps the family the target was resolved to
+        QStringList arguments;
+        arguments << numericHost(targetAddress(targets[i]));
+        if(count > 0) {
+            arguments << "-c" << QString::number(count);
+        }
+        arguments << "-i" << QString::number(second);
+
+        process->process.setProcessEnvironment(environment);
+        self->connect(&process->process, &QProcess::readyReadStandardOutput, [=](){ readProcess(process); });
+        self->connect(&process->process, &QProcess::readyReadStandardError, [=](){
+            emit self->output(QString::fromLocal8Bit(process->process.readAllStandardError()).trimmed());
+        });
+        process->process.start("ping", arguments);
+    }
 }
 
-double Ping::avg() const
+void Ping::Impl::stopProcesses()
 {
-    return impl->avg;
+    for(int i = 0; i < processes.size(); ++i) {
+        PingProcess* process = processes[i];
+        process->process.kill();
+        process->process.waitForFinished(1000);
+        delete process;
+    }
+    processes.clear();
 }
 
-double Ping::max() const
+void Ping::Impl::readProcess(PingProcess* process)
 {
-    return impl->max;
+    // read into a fixed buffer and let the parser carry partial lines over
+    char buffer[4096];
+    qint64 length;
+    while((length = process->process.read(buffer, sizeof(buffer))) > 0) {
+        process->parser.feed(buffer, (int)length);
+    }
 }
 
-double Ping::mdev() const
+void Ping::Impl::addReply(const int& index, const PingReply& reply)
 {
-    return impl->mdev;
+    // the ping command only reports replies, so transmissions are inferred from icmp_seq
+    // and the probes in flight are only resolved when the command stops
+    PingTarget& target = targets[index];
+    while(target.transmitted_packets < reply.sequence) {
+        addProbe(index, (quint16)(target.transmitted_packets + 1), 0);
+    }
+
+    PingSample sample;
+    sample.time = now(CLOCK_REALTIME) / 1000;
+    sample.rtt = reply.time;
+    sample.target = index;
+    sample.sequence = (quint16)reply.sequence;
+    sample.flags = PingSample::Reply;
+    sample.ttl = (qint16)reply.ttl;
+    sample.bytes = (quint16)reply.bytes;
+    sample.forward = 0.0;
+    sample.reverse = 0.0;
+    addSample(sample);
 }
 
-double Ping::loss() const
+int Ping::Impl::resolve(const QString& address, struct sockaddr_in& addr, struct sockaddr_in6& addr6)
 {
-    return impl->loss;
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    struct addrinfo* result = nullptr;
+    int ret = getaddrinfo(address.toLocal8Bit().constData(), nullptr, &hints, &result);
+    if(ret != 0) {
+        emit self->output(QString("ping: %1: %2").arg(address).arg(gai_strerror(ret)));
+        return 0;
+    }
+
+    // the first address of each family, in the order of the resolver
+    int found = 0;
+    memset(&addr, 0, sizeof(addr));
+    memset(&addr6, 0, sizeof(addr6));
+    for(struct addrinfo* info = result; info; info = info->ai_next) {
+        if(info->ai_family == AF_INET && !(found & FoundIpv4)) {
+            memcpy(&addr, info->ai_addr, sizeof(addr));
+            found |= FoundIpv4;
+        } else if(info->ai_family == AF_INET6 && !(found & FoundIpv6)) {
+            memcpy(&addr6, info->ai_addr, sizeof(addr6));
+            found |= FoundIpv6;
+        }
+    }
+    freeaddrinfo(result);
+    return found;
 }
 
-int Ping::transmittedPackets() const
+const struct sockaddr* Ping::Impl::targetAddress(const PingTarget& target) const
 {
-    return impl->transmitted_packets;
+    if(target.family == AF_INET6) {
+        return (const struct sockaddr*)&target.addr6;
+    }
+    return (const struct sockaddr*)&target.addr;
 }
 
-int Ping::receivedPackets() const
+socklen_t Ping::Impl::targetAddressLength(const PingTarget& target) const
 {
-    return impl->received_packets;
+    return target.family == AF_INET6 ? sizeof(target.addr6) : sizeof(target.addr);
 }
 
-void Ping::Impl::write()
+bool Ping::Impl::matches(const PingTarget& target, const struct sockaddr_storage& from) const
 {
-    if(address.isEmpty()) {
-        return;
+    if(from.ss_family != target.family) {
+        return false;
     }
-    QByteArray data;
-    data.append("LANG=C ping " + address);
-    if(count > 0) {
-        data.append(QString(" -c %1").arg(count));
+    if(target.family == AF_INET6) {
+        const struct sockaddr_in6* addr6 = (const struct sockaddr_in6*)&from;
+        return memcmp(&addr6->sin6_addr, &target.addr6.sin6_addr, sizeof(struct in6_addr)) == 0;
     }
-    data.append(QString(" -i %1").arg(second));
-    data.append("\n");
-    process.write(data);
+    return ((const struct sockaddr_in*)&from)->sin_addr.s_addr == target.addr.sin_addr.s_addr;
 }
 
-bool Ping::started()
+bool Ping::Impl::openSockets()
 {
-    return impl->is_started;
-}
+    has_timestamps = false;
+    clock = CLOCK_MONOTONIC;
 
-void Ping::Impl::on_process_finished(const int& exitCode, QProcess::ExitStatus exitStatus)
-{
-    QString text = process.readAllStandardOutput().trimmed();
-    emit self->output(text);
-    // emit self->output("Finished");
-}
+    // every handshake opens its own socket
+    if(mode == TcpConnect) {
+        return true;
+    }
 
-void Ping::Impl::on_process_readyReadStandardError()
-{
-    QString text = process.readAllStandardError();
-    emit self->output(text);
+    // a socket per family that is probed, so a dual-stack run shares the send and receive paths
+    bool has4 = false;
+    bool has6 = false;
+    for(int i = 0; i < targets.size(); ++i) {
+        has4 |= targets[i].family == AF_INET;
+        has6 |= targets[i].family == AF_INET6;
+    }
+    if((has4 && !openSocket(socket4)) || (has6 && !openSocket(socket6))) {
+        closeSocket();
+        return false;
+    }
+
+    if(is_high_rate) {
+        enableTimestamps();
+    }
+    if(mode == Twamp) {
+        // the timestamps are compared with those of the reflector
+        clock = CLOCK_REALTIME;
+    }
+    initializeBatch();
+    return true;
 }
 
-void Ping::Impl::on_process_readyReadStandardOutput()
+bool Ping::Impl::openSocket(PingSocket& sock)
 {
-    QString text = process.readAllStandardOutput().trimmed();
-    emit self->output(text);
+    bool is_ipv6 = sock.family == AF_INET6;
+    int protocol = is_ipv6 ? (int)IPPROTO_ICMPV6 : (int)IPPROTO_ICMP;
 
-    QStringList list = text.split(" ");
-    for(int i = 0; i < list.size(); ++i) {
-        QString element = list.at(i);
-        if(element.contains("time=")) {
-            QStringList list2 = element.split("=");
-            if(list2.size() == 2) {
-                times.push_back(list2[1].toDouble());
-                min = *std::min_element(times.constBegin(), times.constEnd());
-                avg = std::accumulate(times.constBegin(), times.constEnd(), 0.0) / (double)times.size();
-                max = *std::max_element(times.constBegin(), times.constEnd());
-                double sum = 0.0;
-                for(int j = 0; j < times.size(); ++j) {
-                    double time = times[j];
-                    sum += (time - avg) * (time - avg);
-                }
-                mdev = qSqrt(sum / (double)times.size());
-            }
+    // an unprivileged ICMP datagram socket is used when net.ipv4.ping_group_range allows it,
+    // otherwise a raw socket which requires CAP_NET_RAW
+    sock.is_raw = false;
+    if(mode == UdpEcho || mode == Twamp) {
+        sock.fd = socket(sock.family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+    } else {
+        sock.fd = socket(sock.family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol);
+        if(sock.fd < 0) {
+            sock.is_raw = true;
+            sock.fd = socket(sock.family, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol);
         }
     }
+    if(sock.fd < 0) {
+        emit self->output(QString("ping: socket: %1").arg(strerror(errno)));
+        return false;
+    }
 
-    for(int i = 0; i < list.size(); ++i) {
-        QString element = list.at(i);
-        if(element.contains("icmp_seq=")) {
-            QStringList list2 = element.split("=");
-            if(list2.size() == 2) {
-                int seq = list2[1].toInt();
-                transmitted_packets = seq;
-                received_packets = seq - (seq - times.size());
-                loss = ((double)seq - (double)times.size()) / (double)seq * 100.0;
-            }
+    int on = 1;
+    if(is_ipv6) {
+        setsockopt(sock.fd, IPPROTO_IPV6, IPV6_RECVHOPLIMIT, &on, sizeof(on));
+        if(sock.is_raw) {
+            // a raw ICMPv6 socket would see the neighbor discovery as well, the kernel fills in
+            // the checksum of the probes on both socket types
+            struct icmp6_filter filter;
+            ICMP6_FILTER_SETBLOCKALL(&filter);
+            ICMP6_FILTER_SETPASS(ICMP6_ECHO_REPLY, &filter);
+            setsockopt(sock.fd, IPPROTO_ICMPV6, ICMP6_FILTER, &filter, sizeof(filter));
+        }
+    } else {
+        setsockopt(sock.fd, IPPROTO_IP, IP_RECVTTL, &on, sizeof(on));
+    }
+    if(is_tracing) {
+        // the routers on the way answer with time exceeded, which comes back on the error queue
+        // of both socket types with the router as the offender
+        setsockopt(sock.fd, is_ipv6 ? IPPROTO_IPV6 : IPPROTO_IP, is_ipv6 ? IPV6_RECVERR : IP_RECVERR,
+            &on, sizeof(on));
+    } else if(is_sweeping) {
+        // DF without the cached path MTU, so every size gets tried, and the fragmentation
+        // needed errors as well as the local EMSGSIZE come back on the error queue,
+        // IPv6 routers never fragment and answer with packet too big instead
+        if(is_ipv6) {
+            int discover = IPV6_PMTUDISC_PROBE;
+            setsockopt(sock.fd, IPPROTO_IPV6, IPV6_MTU_DISCOVER, &discover, sizeof(discover));
+            setsockopt(sock.fd, IPPROTO_IPV6, IPV6_RECVERR, &on, sizeof(on));
+        } else {
+            int discover = IP_PMTUDISC_PROBE;
+            setsockopt(sock.fd, IPPROTO_IP, IP_MTU_DISCOVER, &discover, sizeof(discover));
+            setsockopt(sock.fd, IPPROTO_IP, IP_RECVERR, &on, sizeof(on));
         }
     }
+    sock.tx_counter = 0;
+
+    // EPOLLERR is always reported and signals transmit timestamps on the error queue
+    PingSocket* probe_socket = &sock;
+    sockets.add(sock.fd, [=](int, quint32 events){
+        if(events & EPOLLERR) {
+            receiveErrors(*probe_socket);
+        }
+        if(events & EPOLLIN) {
+            receive(*probe_socket);
+        }
+    }, EPOLLIN);
+    return true;
 }
 
-void Ping::Impl::on_process_stateChanged(QProcess::ProcessState newState)
+void Ping::Impl::enableTimestamps()
 {
-    switch(newState) {
-        case QProcess::NotRunning:
-            // emit self->output("Not runnging");
-            break;
-        case QProcess::Starting:
-            // emit self->output("Starting");
+    // kernel timestamps are taken on CLOCK_REALTIME, so the payload has to use the same clock
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE
+        | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+    has_timestamps = true;
+    for(PingSocket* sock : { &socket4, &socket6 }) {
+        if(sock->fd < 0 || setsockopt(sock->fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0) {
+            continue;
+        }
+        int on = 1;
+        if(setsockopt(sock->fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) != 0) {
+            has_timestamps = false;
+        }
+    }
+    if(has_timestamps) {
+        clock = CLOCK_REALTIME;
+    } else {
+        emit self->output("ping: kernel timestamps are not available, using userland timestamps");
+    }
+}
+
+void Ping::Impl::initializeBatch()
+{
+    // every packet starts from the same template, so sending only patches the sequence,
+    // the payload and the checksum
+    char packet[PacketLength];
+    int length = PacketLength;
+    memset(packet, 0, sizeof(packet));
+    if(mode == Twamp) {
+        TwampSenderPacket twamp;
+        memset(&twamp, 0, sizeof(twamp));
+        twamp.error_estimate = htons(TwampErrorEstimate);
+        memcpy(packet, &twamp, sizeof(twamp));
+        length = TwampPacketLength;
+    } else {
+        struct icmphdr* icmp = (struct icmphdr*)packet;
+        icmp->type = ICMP_ECHO;
+        icmp->code = 0;
+        icmp->un.echo.id = htons(identifier);
+    }
+    template_sum = partialSum(packet, sizeof(struct icmphdr));
+
+    memset(batch.tx_msgs, 0, sizeof(batch.tx_msgs));
+    memset(batch.rx_msgs, 0, sizeof(batch.rx_msgs));
+    for(int i = 0; i < BatchSize; ++i) {
+        memcpy(batch.tx_packets[i], packet, sizeof(packet));
+        batch.tx_iovs[i][0].iov_base = batch.tx_packets[i];
+        batch.tx_iovs[i][0].iov_len = length;
+        batch.tx_iovs[i][1].iov_base = zeros;
+        batch.tx_iovs[i][1].iov_len = 0;
+        batch.tx_msgs[i].msg_hdr.msg_iov = batch.tx_iovs[i];
+        batch.tx_msgs[i].msg_hdr.msg_iovlen = 2;
+
+        batch.rx_iovs[i].iov_base = batch.rx_packets[i];
+        batch.rx_iovs[i].iov_len = ReceiveLength;
+        batch.rx_msgs[i].msg_hdr.msg_iov = &batch.rx_iovs[i];
+        batch.rx_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    batch.num_pending = 0;
+    batch.num_pending6 = 0;
+}
+
+void Ping::Impl::closeSocket()
+{
+    sockets.clear();
+    for(PingSocket* sock : { &socket4, &socket6 }) {
+        if(sock->fd >= 0) {
+            ::close(sock->fd);
+            sock->fd = -1;
+        }
+    }
+}
+
+int Ping::transmittedPackets() const
+{
+    return impl->transmitted_packets;
+}
+
+int Ping::receivedPackets() const
+{
+    return impl->received_packets;
+}
+
+int Ping::lostPackets() const
+{
+    return impl->lost_packets;
+}
+
+const RttStatistics& Ping::statistics() const
+{
+    return impl->statistics;
+}
+
+double Ping::min() const
+{
+    return impl->statistics.min();
+}
+
+double Ping::avg() const
+{
+    return impl->statistics.avg();
+}
+
+double Ping::max() const
+{
+    return impl->statistics.max();
+}
+
+double Ping::mdev() const
+{
+    return impl->statistics.mdev();
+}
+
+double Ping::p50() const
+{
+    return impl->statistics.percentile(50.0);
+}
+
+double Ping::p90() const
+{
+    return impl->statistics.percentile(90.0);
+}
+
+double Ping::p99() const
+{
+    return impl->statistics.percentile(99.0);
+}
+
+double Ping::p999() const
+{
+    return impl->statistics.percentile(99.9);
+}
+
+double Ping::loss() const
+{
+    return impl->loss;
+}
+
+int Ping::numTargets() const
+{
+    return impl->targets.size();
+}
+
+QString Ping::address(const int& index) const
+{
+    return impl->targets[index].address;
+}
+
+int Ping::transmittedPackets(const int& index) const
+{
+    return impl->targets[index].transmitted_packets;
+}
+
+int Ping::receivedPackets(const int& index) const
+{
+    return impl->targets[index].received_packets;
+}
+
+double Ping::loss(const int& index) const
+{
+    const PingTarget& target = impl->targets[index];
+    if(target.transmitted_packets == 0) {
+        return 0.0;
+    }
+    return (double)target.tracker.lost() / (double)target.transmitted_packets * 100.0;
+}
+
+int Ping::lostPackets(const int& index) const
+{
+    return impl->targets[index].tracker.lost();
+}
+
+int Ping::duplicatePackets(const int& index) const
+{
+    return impl->targets[index].tracker.duplicates();
+}
+
+int Ping::reorderedPackets(const int& index) const
+{
+    return impl->targets[index].tracker.reordered();
+}
+
+int Ping::latePackets(const int& index) const
+{
+    return impl->targets[index].tracker.late();
+}
+
+double Ping::lastRtt(const int& index) const
+{
+    return impl->targets[index].last_rtt;
+}
+
+double Ping::jitter(const int& index) const
+{
+    return impl->targets[index].jitter;
+}
+
+Ping::Family Ping::targetFamily(const int& index) const
+{
+    return impl->targets[index].family == AF_INET6 ? Ipv6 : Ipv4;
+}
+
+const RttStatistics& Ping::familyStatistics(const Family& family) const
+{
+    return family == Ipv6 ? impl->statistics6 : impl->statistics4;
+}
+
+const LossStatistics& Ping::lossStatistics(const int& index) const
+{
+    return impl->targets[index].losses;
+}
+
+const SizeStatistics& Ping::sizeStatistics(const int& index) const
+{
+    return impl->targets[index].sizes;
+}
+
+const RttStatistics& Ping::idleStatistics(const int& index) const
+{
+    return index < impl->idle_statistics.size() ? impl->idle_statistics[index] : impl->targets[index].statistics;
+}
+
+const RttStatistics& Ping::loadedStatistics(const int& index) const
+{
+    return index < impl->loaded_statistics.size() ? impl->loaded_statistics[index] : impl->targets[index].statistics;
+}
+
+const RttStatistics& Ping::statistics(const int& index) const
+{
+    return impl->targets[index].statistics;
+}
+
+const RttStatistics& Ping::forwardStatistics(const int& index) const
+{
+    return impl->targets[index].forward_statistics;
+}
+
+const RttStatistics& Ping::reverseStatistics(const int& index) const
+{
+    return impl->targets[index].reverse_statistics;
+}
+
+double Ping::forwardJitter(const int& index) const
+{
+    return impl->targets[index].forward_jitter;
+}
+
+double Ping::reverseJitter(const int& index) const
+{
+    return impl->targets[index].reverse_jitter;
+}
+
+double Ping::clockOffset(const int& index) const
+{
+    return (double)impl->targets[index].clock_offset / 1000000.0;
+}
+
+bool Ping::started()
+{
+    return impl->is_started;
+}
+
+int Ping::hop(const int& index) const
+{
+    return impl->targets[index].hop;
+}
+
+QString Ping::responder(const int& index) const
+{
+    const struct sockaddr_storage& responder = impl->targets[index].responder;
+    if(responder.ss_family != AF_INET && responder.ss_family != AF_INET6) {
+        return QString();
+    }
+    return numericHost((const struct sockaddr*)&responder);
+}
+
+bool Ping::beyondDestination(const int& index) const
+{
+    return impl->isBeyond(index);
+}
+
+QStringList Ping::expandAddresses(const QString& text)
+{
+    QStringList addresses;
+    // the empty parts are skipped here, the flag for it moved between Qt 5.12 and 5.14
+    QStringList list = text.split(QRegularExpression("[,;\\s]+"));
+    for(int i = 0; i < list.size(); ++i) {
+        const QString& element = list.at(i);
+        if(element.isEmpty()) {
+            continue;
+        }
+        QStringList list2 = element.split("/");
+        if(list2.size() != 2) {
+            addresses << element;
+            continue;
+        }
+
+        struct in_addr network;
+        struct in6_addr network6;
+        bool ok = false;
+        int mask = list2.at(1).toInt(&ok);
+        if(ok && mask >= 0 && mask <= 128
+                && inet_pton(AF_INET6, list2.at(0).toLatin1().constData(), &network6) == 1) {
+            // IPv6 ranges are capped the same way, i.e. at a /116
+            int bits = 128 - mask;
+            if(bits > 16 || (1 << bits) > MaxCidrHosts) {
+                // left as it is, start() reports it
+                addresses << element;
+                continue;
+            }
+            quint32 size = 1U << bits;
+            quint32 first = ((quint32)network6.s6_addr[14] << 8 | network6.s6_addr[15]) & ~(size - 1);
+            if(size > 2) {
+                // skip the subnet-router anycast address
+                ++first;
+            }
+            quint32 last = (((quint32)network6.s6_addr[14] << 8 | network6.s6_addr[15]) | (size - 1)) & 0xffff;
+            for(quint32 host = first; host <= last; ++host) {
+                struct in6_addr addr = network6;
+                addr.s6_addr[14] = (quint8)(host >> 8);
+                addr.s6_addr[15] = (quint8)(host & 0xff);
+                char buffer[INET6_ADDRSTRLEN];
+                inet_ntop(AF_INET6, &addr, buffer, sizeof(buffer));
+                addresses << QString(buffer);
+            }
+            continue;
+        }
+        if(!ok || mask < 0 || mask > 32
+                || inet_pton(AF_INET, list2.at(0).toLatin1().constData(), &network) != 1) {
+            addresses << element;
+            continue;
+        }
+
+        quint64 size = 1ULL << (32 - mask);
+        if(size > MaxCidrHosts) {
+            addresses << element;
+            continue;
+        }
+        quint32 first = ntohl(network.s_addr) & (quint32)~(size - 1);
+        quint32 last = first + (quint32)(size - 1);
+        if(size > 2) {
+            // skip the network and broadcast addresses
+            ++first;
+            --last;
+        }
+        for(quint64 host = first; host <= last; ++host) {
+            struct in_addr addr;
+            addr.s_addr = htonl((quint32)host);
+            char buffer[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &addr, buffer, sizeof(buffer));
+            addresses << QString(buffer);
+        }
+    }
+    addresses.removeDuplicates();
+    return addresses;
+}
+
+qint64 Ping::Impl::interval() const
+{
+    // the ping command refuses intervals below 0.2 s to unprivileged users
+    return (qint64)(qMax(second, is_high_rate ? MinHighRateWait : MinWait) * 1000000000.0);
+}
+
+qint64 Ping::Impl::timeoutInterval() const
+{
+    return (qint64)(timeout * 1000000000.0);
+}
+
+void Ping::Impl::schedule()
+{
+    qint64 next = wheel.nextExpiry();
+    qint64 next_timeout = timeouts.nextExpiry();
+    if(next_timeout >= 0 && (next < 0 || next_timeout < next)) {
+        next = next_timeout;
+    }
+    if(next < 0) {
+        return;
+    }
+    qint64 delay = next - now();
+    sendTimer.start(delay > 0 ? (int)((delay + 999999) / 1000000) : 0);
+}
+
+void Ping::Impl::addProbe(const int& index, const quint16& sequence, const qint64& sent)
+{
+    PingTarget& target = targets[index];
+    SequenceTracker& tracker = target.tracker;
+    lost_packets -= tracker.lost();
+    tracker.sent(sequence, sent);
+    lost_packets += tracker.lost();
+
+    ++target.transmitted_packets;
+    ++transmitted_packets;
+    updateLoss();
+}
+
+void Ping::Impl::expireProbes(const qint64& time)
+{
+    // the ids carry the target in the upper and the sequence in the lower half
+    timeouts.expire(time, expired);
+    for(size_t i = 0; i < expired.size(); ++i) {
+        quint32 id = (quint32)expired[i];
+        int index = (int)(id >> 16);
+        SequenceTracker& tracker = targets[index].tracker;
+        if(tracker.expire((quint16)(id & 0xffff))) {
+            ++lost_packets;
+            emit self->targetUpdated(index);
+        }
+    }
+    updateLoss();
+}
+
+void Ping::Impl::updateLoss()
+{
+    loss = transmitted_packets > 0 ? (double)lost_packets / (double)transmitted_packets * 100.0 : 0.0;
+}
+
+void Ping::Impl::send(const int& index)
+{
+    if(mode == TcpConnect) {
+        connectTarget(index);
+        return;
+    }
+
+    PingTarget& target = targets[index];
+    ++target.sequence;
+
+    qint64 sent = now(clock);
+    bool is_ipv6 = target.family == AF_INET6;
+    int position = is_ipv6 ? BatchSize - 1 - batch.num_pending6++ : batch.num_pending++;
+    char* packet = batch.tx_packets[position];
+    batch.tx_indices[position] = index;
+    batch.tx_msgs[position].msg_hdr.msg_name = (void*)targetAddress(target);
+    batch.tx_msgs[position].msg_hdr.msg_namelen = targetAddressLength(target);
+
+    if(mode == Twamp) {
+        // the target index fits the upper half since CIDR ranges are capped at MaxCidrHosts
+        TwampSenderPacket* twamp = (TwampSenderPacket*)packet;
+        twamp->sequence = htonl(((quint32)index << 16) | target.sequence);
+        twamp->timestamp = toNtpTimestamp(sent);
+    } else {
+        // the UDP probe carries the same header and payload, the reflector returns it unchanged
+        // an ICMPv6 echo request has the same layout, only the type differs
+        struct icmphdr* icmp = (struct icmphdr*)packet;
+        icmp->type = is_ipv6 && mode == Icmp ? ICMP6_ECHO_REQUEST : ICMP_ECHO;
+        icmp->un.echo.sequence = htons(target.sequence);
+        if(is_tracing) {
+            // routers need not quote more than the header of the probe, so the wire sequence
+            // is a running number that leads back to the hop and its own sequence
+            TxRecord& record = hop_records[++hop_sequence];
+            record.index = index;
+            record.sequence = target.sequence;
+            icmp->un.echo.sequence = htons(hop_sequence);
+
+            // the TTL goes along with each message, so the hops share one sendmmsg,
+            // IP_TTL as ancillary data needs Linux 4.6
+            struct msghdr& msg = batch.tx_msgs[position].msg_hdr;
+            msg.msg_control = batch.tx_controls[position];
+            msg.msg_controllen = sizeof(batch.tx_controls[position]);
+            struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = is_ipv6 ? IPPROTO_IPV6 : IPPROTO_IP;
+            cmsg->cmsg_type = is_ipv6 ? IPV6_HOPLIMIT : IP_TTL;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(cmsg), &target.hop, sizeof(int));
+        }
+
+        // the send time and the target travel in the payload, so replies need no lookup
+        Payload payload;
+        memset(&payload, 0, sizeof(payload));
+        payload.sent = sent;
+        payload.index = (quint32)index;
+        memcpy(packet + sizeof(struct icmphdr), &payload, sizeof(payload));
+
+        // the checksum of ICMPv6 covers a pseudo header and is left to the kernel
+        quint32 sum = partialSum(&icmp->un.echo.sequence, sizeof(icmp->un.echo.sequence), template_sum);
+        icmp->checksum = foldSum(partialSum(&payload, sizeof(payload), sum));
+
+        if(is_sweeping) {
+            // the sizes take turns, so each one sees the same conditions over time
+            const SizeStatistics& sizes = target.sizes;
+            int size = sizes.size((target.sequence - 1) % sizes.numSizes());
+            batch.tx_iovs[position][1].iov_len = size - headerLength(target.family) - PacketLength;
+        }
+    }
+
+    addProbe(index, target.sequence, sent);
+    timeouts.schedule((int)(((quint32)index << 16) | target.sequence), now() + timeoutInterval());
+
+    if(batch.num_pending + batch.num_pending6 == BatchSize) {
+        flush();
+    }
+}
+
+void Ping::Impl::flush()
+{
+    int num_pending = batch.num_pending;
+    int num_pending6 = batch.num_pending6;
+    batch.num_pending = 0;
+    batch.num_pending6 = 0;
+    flush(socket4, 0, num_pending);
+    flush(socket6, BatchSize - num_pending6, num_pending6);
+
+    for(int i = 0; i < num_pending; ++i) {
+        emit self->targetUpdated(batch.tx_indices[i]);
+    }
+    for(int i = BatchSize - num_pending6; i < BatchSize; ++i) {
+        emit self->targetUpdated(batch.tx_indices[i]);
+    }
+}
+
+void Ping::Impl::flush(PingSocket& sock, const int& first, const int& count)
+{
+    int position = first;
+    int end = first + count;
+    while(position < end) {
+        int ret = sendmmsg(sock.fd, &batch.tx_msgs[position], end - position, 0);
+        if(ret < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            // sendmmsg stops at the first failure, so report that probe and go on with the rest,
+            // oversized probes of the sweep are expected and come back on the error queue
+            const PingTarget& target = targets[batch.tx_indices[position]];
+            if(!is_sweeping || errno != EMSGSIZE) {
+                emit self->output(QString("ping: %1: sendmsg: %2").arg(target.address).arg(strerror(errno)));
+            }
+            ++position;
+            continue;
+        }
+        if(has_timestamps) {
+            // SOF_TIMESTAMPING_OPT_ID numbers every successful send of the socket
+            for(int i = position; i < position + ret; ++i) {
+                TxRecord& record = sock.tx_records[sock.tx_counter++ % TxRingSize];
+                record.index = batch.tx_indices[i];
+                record.sequence = targets[record.index].sequence;
+            }
+        }
+        position += ret;
+    }
+}
+
+void Ping::Impl::connectTarget(const int& index)
+{
+    PingTarget& target = targets[index];
+    ++target.sequence;
+    qint64 sent = now();
+    addProbe(index, target.sequence, sent);
+    timeouts.schedule((int)(((quint32)index << 16) | target.sequence), sent + timeoutInterval());
+    emit self->targetUpdated(index);
+
+    if(connects.size() >= (size_t)MaxConnects) {
+        closeConnect(0);
+    }
+
+    int sock = socket(target.family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    if(sock < 0) {
+        emit self->output(QString("ping: %1: socket: %2").arg(target.address).arg(strerror(errno)));
+        return;
+    }
+    // abort with a reset on close, so short-lived probes don't pile up in TIME_WAIT
+    struct linger lg = { 1, 0 };
+    setsockopt(sock, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    int on = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    TcpProbe probe = { sock, index, target.sequence, sent };
+    connects.push_back(probe);
+    if(::connect(sock, targetAddress(target), targetAddressLength(target)) == 0) {
+        finishConnect(sock, 0);
+    } else if(errno != EINPROGRESS) {
+        // handshakes that fail at once complete without a round through epoll
+        finishConnect(sock, errno);
+    } else {
+        sockets.add(sock, [=](int, quint32){ finishConnect(sock, socketError(sock)); }, EPOLLOUT);
+    }
+}
+
+void Ping::Impl::finishConnect(const int& sock, const int& error)
+{
+    qint64 time = now();
+    int position = -1;
+    for(size_t i = 0; i < connects.size(); ++i) {
+        if(connects[i].fd == sock) {
+            position = (int)i;
             break;
-        case QProcess::Running:
-            // emit self->output("Running");
-            write();
+        }
+    }
+    if(position < 0) {
+        return;
+    }
+    TcpProbe probe = connects[position];
+    closeConnect(position);
+
+    // a reset is a complete round trip as well, the port is merely closed
+    if(error != 0 && error != ECONNREFUSED) {
+        emit self->output(QString("ping: %1: connect: %2").arg(targets[probe.index].address).arg(strerror(error)));
+        return;
+    }
+
+    PingSample sample;
+    sample.time = now(CLOCK_REALTIME) / 1000;
+    sample.rtt = (double)(time - probe.sent) / 1000000.0;
+    sample.target = probe.index;
+    sample.sequence = probe.sequence;
+    sample.flags = PingSample::Reply | PingSample::Tcp | (error == ECONNREFUSED ? PingSample::Refused : 0);
+    sample.ttl = -1;
+    sample.bytes = 0;
+    sample.forward = 0.0;
+    sample.reverse = 0.0;
+    addSample(sample);
+}
+
+void Ping::Impl::expireConnects(const qint64& time)
+{
+    // handshakes are started in order, so the oldest ones are at the front
+    while(!connects.empty() && time - connects.front().sent >= timeoutInterval()) {
+        closeConnect(0);
+    }
+}
+
+void Ping::Impl::closeConnect(const int& position)
+{
+    int sock = connects[position].fd;
+    sockets.remove(sock);
+    ::close(sock);
+    connects.erase(connects.begin() + position);
+}
+
+void Ping::Impl::receive(PingSocket& sock)
+{
+    while(true) {
+        // recvmmsg shrinks the lengths to what each message used
+        for(int i = 0; i < BatchSize; ++i) {
+            struct msghdr& msg = batch.rx_msgs[i].msg_hdr;
+            msg.msg_name = &batch.rx_from[i];
+            msg.msg_namelen = sizeof(batch.rx_from[i]);
+            msg.msg_control = batch.rx_controls[i];
+            msg.msg_controllen = ControlLength;
+        }
+
+        int n = recvmmsg(sock.fd, batch.rx_msgs, BatchSize, 0, nullptr);
+        if(n <= 0) {
+            break;
+        }
+        qint64 time = now(clock);
+        for(int i = 0; i < n; ++i) {
+            receiveReply(sock, batch.rx_packets[i], batch.rx_msgs[i].msg_len, batch.rx_msgs[i].msg_hdr,
+                batch.rx_from[i], time);
+        }
+        if(n < BatchSize) {
             break;
-        default:
+        }
+    }
+}
+
+void Ping::Impl::receiveReply(const PingSocket& sock, const char* data, ssize_t length, struct msghdr& msg,
+    const struct sockaddr_storage& from, qint64 time)
+{
+    int ttl = -1;
+    for(struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if((cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_TTL)
+                || (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_HOPLIMIT)) {
+            ttl = *(int*)CMSG_DATA(cmsg);
+        } else if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            time = nanoseconds(*(struct timespec*)CMSG_DATA(cmsg));
+        } else if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            const struct scm_timestamping* stamps = (const struct scm_timestamping*)CMSG_DATA(cmsg);
+            if(stamps->ts[0].tv_sec != 0 || stamps->ts[0].tv_nsec != 0) {
+                time = nanoseconds(stamps->ts[0]);
+            }
+        }
+    }
+
+    if(mode == Twamp) {
+        receiveTwamp(data, (int)length, from, time, ttl);
+        return;
+    }
+
+    // raw IPv6 sockets deliver the payload without the header
+    if(sock.is_raw && sock.family == AF_INET) {
+        const struct iphdr* ip = (const struct iphdr*)data;
+        int header_length = ip->ihl * 4;
+        ttl = ip->ttl;
+        data += header_length;
+        length -= header_length;
+    }
+
+    if(length < (ssize_t)(sizeof(struct icmphdr) + sizeof(Payload))) {
+        return;
+    }
+    const struct icmphdr* icmp = (const struct icmphdr*)data;
+    int reply_type = sock.family == AF_INET6 ? ICMP6_ECHO_REPLY : ICMP_ECHOREPLY;
+    if(icmp->type != (mode == UdpEcho ? ICMP_ECHO : reply_type)) {
+        return;
+    }
+    // datagram sockets are demultiplexed by the kernel, raw sockets see every reply
+    if((sock.is_raw || mode == UdpEcho) && ntohs(icmp->un.echo.id) != identifier) {
+        return;
+    }
+
+    Payload payload;
+    memcpy(&payload, data + sizeof(struct icmphdr), sizeof(payload));
+    int index = (int)payload.index;
+    if(index >= targets.size() || !matches(targets[index], from)) {
+        return;
+    }
+
+    quint16 sequence = ntohs(icmp->un.echo.sequence);
+    if(is_tracing) {
+        const TxRecord& record = hop_records[sequence];
+        if(record.index != index) {
+            return;
+        }
+        sequence = record.sequence;
+        updateHop(index, (const struct sockaddr*)&from, true);
+    }
+    qint64 sent = transmitTime(targets[index], sequence, payload.sent);
+    double rtt = (double)(time - sent) / 1000000.0;
+    if(rtt < 0.0) {
+        rtt = (double)(now(clock) - payload.sent) / 1000000.0;
+    }
+
+    PingSample sample;
+    sample.time = (clock == CLOCK_REALTIME ? time : now(CLOCK_REALTIME)) / 1000;
+    sample.rtt = rtt;
+    sample.target = index;
+    sample.sequence = sequence;
+    sample.flags = mode == UdpEcho ? PingSample::Reply | PingSample::Udp : PingSample::Reply;
+    sample.ttl = (qint16)ttl;
+    sample.bytes = (quint16)length;
+    sample.forward = 0.0;
+    sample.reverse = 0.0;
+    addSample(sample);
+}
+
+void Ping::Impl::receiveTwamp(const char* data, const int& length, const struct sockaddr_storage& from,
+    const qint64& time, const int& ttl)
+{
+    if(length < TwampPacketLength) {
+        return;
+    }
+    TwampReflectorPacket packet;
+    memcpy(&packet, data, sizeof(packet));
+
+    quint32 sender_sequence = ntohl(packet.sender_sequence);
+    int index = (int)(sender_sequence >> 16);
+    quint16 sequence = (quint16)(sender_sequence & 0xffff);
+    if(index >= targets.size() || !matches(targets[index], from)) {
+        return;
+    }
+    PingTarget& target = targets[index];
+
+    // t1 and t4 are local, t2 and t3 are remote, the reflector turnaround is left out of the rtt
+    qint64 t1 = transmitTime(target, sequence, fromNtpTimestamp(packet.sender_timestamp));
+    qint64 t2 = fromNtpTimestamp(packet.receive_timestamp);
+    qint64 t3 = fromNtpTimestamp(packet.timestamp);
+    qint64 t4 = time;
+    qint64 forward = t2 - t1;
+    qint64 reverse = t4 - t3;
+    qint64 rtt = forward + reverse;
+    if(rtt < 0) {
+        return;
+    }
+
+    // the round trip with the least queueing splits most evenly, so its offset is kept
+    // until a faster one arrives or the window runs out to follow the drift
+    if(++target.offset_age > OffsetWindow || rtt <= target.offset_rtt) {
+        target.clock_offset = (forward - reverse) / 2;
+        target.offset_rtt = rtt;
+        target.offset_age = 0;
+    }
+
+    PingSample sample;
+    sample.time = t4 / 1000;
+    sample.rtt = (double)rtt / 1000000.0;
+    sample.target = index;
+    sample.sequence = sequence;
+    sample.flags = PingSample::Reply | PingSample::Udp | PingSample::OneWay;
+    sample.ttl = (qint16)ttl;
+    sample.bytes = (quint16)length;
+    sample.forward = (double)(forward - target.clock_offset) / 1000000.0;
+    sample.reverse = (double)(reverse + target.clock_offset) / 1000000.0;
+    addSample(sample);
+}
+
+int Ping::Impl::headerLength(const int& family) const
+{
+    // the sizes of the sweep count the whole IP packet, like the MTU does
+    int length = family == AF_INET6 ? Ipv6HeaderLength : IpHeaderLength;
+    return mode == UdpEcho ? length + UdpHeaderLength : length;
+}
+
+qint64 Ping::Impl::transmitTime(const PingTarget& target, const quint16& sequence, const qint64& sent) const
+{
+    // the tracker holds the kernel transmit timestamp of this very probe once it has arrived
+    qint64 time = target.tracker.sentTime(sequence);
+    return time > 0 ? time : sent;
+}
+
+void Ping::Impl::receiveErrors(PingSocket& sock)
+{
+    char buffer[256];
+    char control[512];
+    struct sockaddr_storage destination;
+    struct iovec iov = { buffer, sizeof(buffer) };
+    struct msghdr msg;
+
+    while(true) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &destination;
+        msg.msg_namelen = sizeof(destination);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t length = recvmsg(sock.fd, &msg, MSG_ERRQUEUE);
+        if(length < 0) {
             break;
+        }
+
+        qint64 stamp = 0;
+        const struct sock_extended_err* error = nullptr;
+        for(struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                const struct scm_timestamping* stamps = (const struct scm_timestamping*)CMSG_DATA(cmsg);
+                stamp = nanoseconds(stamps->ts[0]);
+            } else if((cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR)
+                    || (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+                error = (const struct sock_extended_err*)CMSG_DATA(cmsg);
+            }
+        }
+        bool is_time_exceeded = error
+            && ((error->ee_origin == SO_EE_ORIGIN_ICMP && error->ee_type == ICMP_TIME_EXCEEDED)
+                || (error->ee_origin == SO_EE_ORIGIN_ICMP6 && error->ee_type == ICMP6_TIME_EXCEEDED));
+        if(is_time_exceeded && is_tracing && msg.msg_namelen > 0) {
+            receiveHop(sock, buffer, length, destination, error, stamp != 0 ? stamp : now(clock));
+            continue;
+        }
+        if(error && is_sweeping && msg.msg_namelen > 0) {
+            // the name is the destination of the probe, the offender the hop that dropped it
+            bool is_local = error->ee_origin == SO_EE_ORIGIN_LOCAL && error->ee_errno == EMSGSIZE;
+            bool is_remote = (error->ee_origin == SO_EE_ORIGIN_ICMP && error->ee_type == ICMP_DEST_UNREACH
+                && error->ee_code == ICMP_FRAG_NEEDED)
+                || (error->ee_origin == SO_EE_ORIGIN_ICMP6 && error->ee_type == ICMP6_PACKET_TOO_BIG);
+            for(int i = 0; (is_local || is_remote) && i < targets.size(); ++i) {
+                if(!matches(targets[i], destination)) {
+                    continue;
+                }
+                int mtu = (int)error->ee_info;
+                if(mtu > 0 && (targets[i].sizes.reportedMtu() == 0 || mtu < targets[i].sizes.reportedMtu())) {
+                    QString offender = "local";
+                    if(is_remote) {
+                        offender = numericHost(SO_EE_OFFENDER(error));
+                    }
+                    emit self->output(QString("From %1 icmp_seq=? Frag needed and DF set (mtu = %2) to %3")
+                        .arg(offender).arg(mtu).arg(targets[i].address));
+                }
+                targets[i].sizes.setMtu(mtu);
+            }
+            continue;
+        }
+        if(!error || error->ee_origin != SO_EE_ORIGIN_TIMESTAMPING || stamp == 0) {
+            continue;
+        }
+
+        const TxRecord& record = sock.tx_records[error->ee_data % TxRingSize];
+        if(record.index < targets.size()) {
+            targets[record.index].tracker.setSentTime(record.sequence, stamp);
+        }
+    }
+}
+
+void Ping::Impl::receiveHop(const PingSocket& sock, const char* data, const ssize_t& length,
+    const struct sockaddr_storage& destination, const struct sock_extended_err* error, const qint64& time)
+{
+    // the data is the probe as quoted by the router, the kernel has already checked that
+    // it is one of this socket, raw sockets excepted
+    if(length < (ssize_t)sizeof(struct icmphdr)) {
+        return;
+    }
+    const struct icmphdr* icmp = (const struct icmphdr*)data;
+    if(sock.is_raw && ntohs(icmp->un.echo.id) != identifier) {
+        return;
+    }
+    const TxRecord& record = hop_records[ntohs(icmp->un.echo.sequence)];
+    if(record.index < 0 || record.index >= targets.size() || !matches(targets[record.index], destination)) {
+        return;
+    }
+    qint64 sent = targets[record.index].tracker.sentTime(record.sequence);
+    if(sent <= 0) {
+        return;
+    }
+    updateHop(record.index, SO_EE_OFFENDER(error), false);
+
+    PingSample sample;
+    sample.time = (clock == CLOCK_REALTIME ? time : now(CLOCK_REALTIME)) / 1000;
+    sample.rtt = (double)(time - sent) / 1000000.0;
+    sample.target = record.index;
+    sample.sequence = record.sequence;
+    sample.flags = PingSample::Reply | PingSample::Hop;
+    sample.ttl = -1;
+    sample.bytes = (quint16)length;
+    sample.forward = 0.0;
+    sample.reverse = 0.0;
+    addSample(sample);
+}
+
+void Ping::Impl::updateHop(const int& index, const struct sockaddr* responder, const bool& isDestination)
+{
+    PingTarget& target = targets[index];
+    memcpy(&target.responder, responder,
+        responder->sa_family == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in));
+
+    PingTarget& first = targets[target.first_hop];
+    if(isDestination) {
+        if(first.distance == 0 || target.hop < first.distance) {
+            first.distance = target.hop;
+        }
+        return;
+    }
+    if(first.distance == 0 || target.hop < first.distance) {
+        return;
+    }
+
+    // the path got longer, so the hops behind the old destination are probed again
+    first.distance = 0;
+    qint64 time = now();
+    for(int i = target.first_hop; i < target.first_hop + max_hops; ++i) {
+        if(targets[i].is_parked) {
+            targets[i].is_parked = false;
+            targets[i].due = time;
+            wheel.schedule(i, time);
+        }
+    }
+    schedule();
+}
+
+bool Ping::Impl::isBeyond(const int& index) const
+{
+    const PingTarget& target = targets[index];
+    int distance = targets[target.first_hop].distance;
+    return target.hop > 0 && distance > 0 && target.hop > distance;
+}
+
+void Ping::Impl::addSample(const PingSample& reply)
+{
+    PingTarget& target = targets[reply.target];
+    SequenceTracker& tracker = target.tracker;
+    SequenceTracker::Result result = tracker.received(reply.sequence);
+    if(result == SequenceTracker::Unknown) {
+        return;
+    }
+
+    PingSample sample = reply;
+    if(result == SequenceTracker::Duplicate) {
+        // duplicates are reported but leave the statistics alone
+        sample.flags |= PingSample::Duplicate;
+        shm.push(sample);
+        recorder.append(sample);
+        emit self->sampled(sample);
+        emit self->targetUpdated(sample.target);
+        return;
+    } else if(result == SequenceTracker::Reordered) {
+        sample.flags |= PingSample::Reordered;
+    } else if(result == SequenceTracker::Late) {
+        sample.flags |= PingSample::Late;
+        --lost_packets;
+    }
+
+    // interarrival jitter of RFC 3550 on the round-trip times
+    if(target.statistics.count() > 0) {
+        target.jitter += (qAbs(sample.rtt - target.last_rtt) - target.jitter) / 16.0;
+    }
+    target.statistics.add(sample.rtt);
+    target.last_rtt = sample.rtt;
+    ++target.received_packets;
+    if(is_sweeping) {
+        target.sizes.add(sample.bytes + headerLength(target.family), sample.rtt);
+    }
+
+    if(load != NoLoad) {
+        // the phases are kept apart, so the loaded numbers compare directly with the idle ones
+        if(is_loaded) {
+            sample.flags |= PingSample::Loaded;
+            loaded_statistics[sample.target].add(sample.rtt);
+        } else {
+            idle_statistics[sample.target].add(sample.rtt);
+        }
+    }
+
+    if(sample.flags & PingSample::OneWay) {
+        // interarrival jitter of RFC 3550 per direction
+        if(target.forward_statistics.count() > 0) {
+            target.forward_jitter += (qAbs(sample.forward - target.last_forward) - target.forward_jitter) / 16.0;
+            target.reverse_jitter += (qAbs(sample.reverse - target.last_reverse) - target.reverse_jitter) / 16.0;
+        }
+        target.forward_statistics.add(sample.forward);
+        target.reverse_statistics.add(sample.reverse);
+        target.last_forward = sample.forward;
+        target.last_reverse = sample.reverse;
+    }
+
+    statistics.add(sample.rtt);
+    if(target.family == AF_INET6) {
+        statistics6.add(sample.rtt);
+    } else {
+        statistics4.add(sample.rtt);
+    }
+    ++received_packets;
+    updateLoss();
+    shm.push(sample);
+    recorder.append(sample);
+    emit self->sampled(sample);
+    emit self->targetUpdated(sample.target);
+}
+
+void Ping::Impl::publishSnapshot()
+{
+    if(!shm.isOpen()) {
+        return;
+    }
+
+    // the percentiles walk the histograms, so the snapshot follows a timer rather than every reply
+    shm.beginUpdate();
+    ShmStats& aggregate = shm.aggregate();
+    setStatistics(aggregate, statistics);
+    aggregate.transmitted = transmitted_packets;
+    aggregate.received = received_packets;
+    aggregate.lost = lost_packets;
+    aggregate.duplicates = 0;
+    aggregate.reordered = 0;
+    aggregate.late = 0;
+    aggregate.loss = loss;
+    aggregate.jitter = 0.0;
+    aggregate.last_rtt = 0.0;
+
+    for(int i = 0; i < targets.size(); ++i) {
+        const PingTarget& target = targets[i];
+        const SequenceTracker& tracker = target.tracker;
+        aggregate.duplicates += tracker.duplicates();
+        aggregate.reordered += tracker.reordered();
+        aggregate.late += tracker.late();
+
+        ShmStats* stats = shm.target(i);
+        if(!stats) {
+            continue;
+        }
+        setStatistics(*stats, target.statistics);
+        stats->transmitted = target.transmitted_packets;
+        stats->received = target.received_packets;
+        stats->lost = tracker.lost();
+        stats->duplicates = tracker.duplicates();
+        stats->reordered = tracker.reordered();
+        stats->late = tracker.late();
+        stats->loss = self->loss(i);
+        stats->jitter = target.jitter;
+        stats->last_rtt = target.last_rtt;
+    }
+    shm.endUpdate(is_started);
+}
+
+void Ping::Impl::setStatistics(ShmStats& stats, const RttStatistics& statistics) const
+{
+    stats.min = statistics.min();
+    stats.avg = statistics.avg();
+    stats.max = statistics.max();
+    stats.mdev = statistics.mdev();
+    stats.p50 = statistics.percentile(50.0);
+    stats.p90 = statistics.percentile(90.0);
+    stats.p99 = statistics.percentile(99.0);
+    stats.p999 = statistics.percentile(99.9);
+}
+
+void Ping::Impl::startLoad()
+{
+    // the flows are spread over the targets, each of which is expected to run the sink
+    int destination = load_port > 0 ? load_port : DefaultSinkPort;
+    LoadGenerator::Protocol protocol = load == TcpLoad ? LoadGenerator::Tcp : LoadGenerator::Udp;
+    for(int i = 0; i < num_flows; ++i) {
+        PingTarget target = targets[i % targets.size()];
+        target.addr.sin_port = htons((quint16)destination);
+        target.addr6.sin6_port = htons((quint16)destination);
+        load_generator.addFlow(protocol, targetAddress(target), targetAddressLength(target));
+    }
+    is_loaded = true;
+    emit self->output(QString("--- load: %1 %2 flows to port %3 ---")
+        .arg(num_flows).arg(load == TcpLoad ? "tcp" : "udp").arg(destination));
+}
+
+void Ping::Impl::on_sendTimer_timeout()
+{
+    qint64 period = interval();
+    qint64 time = now();
+    expireConnects(time);
+    expireProbes(time);
+    wheel.expire(time, expired);
+    for(size_t i = 0; i < expired.size(); ++i) {
+        int index = expired[i];
+        PingTarget& target = targets[index];
+        if(is_tracing && isBeyond(index)) {
+            // nothing to learn behind the destination, until the path grows longer again
+            target.is_parked = true;
+            emit self->targetUpdated(index);
+            continue;
+        }
+        send(index);
+
+        if(count > 0 && target.transmitted_packets >= count) {
+            continue;
+        }
+        target.due += period;
+        if(target.due <= time) {
+            // resynchronize after a stall instead of sending a burst
+            target.due = time + period;
+        }
+        wheel.schedule(index, target.due);
+    }
+    if(batch.num_pending + batch.num_pending6 > 0) {
+        flush();
     }
+    schedule();
 }
 
 }
@@ -0,0 +1,204 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/ping_log_model.h"
+
+#include <QVector>
+
+namespace {
+
+const int DefaultCapacity = 10000;
+
+struct LogEntry {
+    rqt_ping::PingSample sample;
+    QString text;    // set for messages, empty for samples
+};
+
+}
+
+namespace rqt_ping {
+
+class PingLogModel::Impl
+{
+public:
+    PingLogModel* self;
+
+    Impl(PingLogModel* self);
+
+    LogEntry& push();
+    QString format(const LogEntry& entry) const;
+
+    QVector<LogEntry> entries;
+    QStringList targets;
+    int head;
+    int size;
+};
+
+
+PingLogModel::PingLogModel(QObject* parent)
+    : QAbstractListModel(parent)
+{
+    impl = new Impl(this);
+}
+
+PingLogModel::Impl::Impl(PingLogModel* self)
+    : self(self)
+{
+    entries.resize(DefaultCapacity);
+    head = 0;
+    size = 0;
+}
+
+PingLogModel::~PingLogModel()
+{
+    delete impl;
+}
+
+void PingLogModel::setCapacity(const int& capacity)
+{
+    if(capacity > 0 && capacity != impl->entries.size()) {
+        beginResetModel();
+        impl->entries.clear();
+        impl->entries.resize(capacity);
+        impl->head = 0;
+        impl->size = 0;
+        endResetModel();
+    }
+}
+
+int PingLogModel::capacity() const
+{
+    return impl->entries.size();
+}
+
+void PingLogModel::setTargets(const QStringList& targets)
+{
+    impl->targets = targets;
+}
+
+LogEntry& PingLogModel::Impl::push()
+{
+    // the oldest row leaves the model before the newest one enters,
+    // so the buffer never grows past its capacity
+    int capacity = entries.size();
+    if(size == capacity) {
+        self->beginRemoveRows(QModelIndex(), 0, 0);
+        head = (head + 1) % capacity;
+        --size;
+        self->endRemoveRows();
+    }
+
+    self->beginInsertRows(QModelIndex(), size, size);
+    LogEntry& entry = entries[(head + size) % capacity];
+    ++size;
+    return entry;
+}
+
+void PingLogModel::append(const PingSample& sample)
+{
+    LogEntry& entry = impl->push();
+    entry.sample = sample;
+    entry.text.clear();
+    endInsertRows();
+}
+
+void PingLogModel::append(const PingSample* samples, const int& count)
+{
+    int capacity = impl->entries.size();
+    int n = qMin(count, capacity);
+    samples += count - n;
+    if(n <= 0) {
+        return;
+    }
+
+    int overflow = impl->size + n - capacity;
+    if(overflow > 0) {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        impl->head = (impl->head + overflow) % capacity;
+        impl->size -= overflow;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), impl->size, impl->size + n - 1);
+    for(int i = 0; i < n; ++i) {
+        LogEntry& entry = impl->entries[(impl->head + impl->size + i) % capacity];
+        entry.sample = samples[i];
+        entry.text.clear();
+    }
+    impl->size += n;
+    endInsertRows();
+}
+
+void PingLogModel::append(const QString& text)
+{
+    LogEntry& entry = impl->push();
+    entry.sample.flags = 0;
+    entry.text = text;
+    endInsertRows();
+}
+
+void PingLogModel::clear()
+{
+    beginResetModel();
+    for(int i = 0; i < impl->entries.size(); ++i) {
+        impl->entries[i].text.clear();
+    }
+    impl->head = 0;
+    impl->size = 0;
+    endResetModel();
+}
+
+int PingLogModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : impl->size;
+}
+
+QVariant PingLogModel::data(const QModelIndex& index, int role) const
+{
+    if(!index.isValid() || index.row() >= impl->size || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    // text is only built here, i.e. for rows the view actually paints
+    const LogEntry& entry = impl->entries[(impl->head + index.row()) % impl->entries.size()];
+    return impl->format(entry);
+}
+
+QString PingLogModel::Impl::format(const LogEntry& entry) const
+{
+    if(!entry.text.isEmpty() || !(entry.sample.flags & PingSample::Reply)) {
+        return entry.text;
+    }
+
+    const PingSample& sample = entry.sample;
+    QString address = sample.target < targets.size() ? targets.at(sample.target) : QString::number(sample.target);
+    QString text;
+    if(sample.flags & PingSample::Hop) {
+        text = QString("From %1: icmp_seq=%2 Time to live exceeded").arg(address).arg(sample.sequence);
+    } else if(sample.flags & PingSample::Tcp) {
+        text = QString("%1 %2: seq=%3").arg(sample.flags & PingSample::Refused ? "refused by" : "connected to")
+            .arg(address).arg(sample.sequence);
+    } else {
+        text = QString("%1 bytes from %2: %3=%4").arg(sample.bytes).arg(address)
+            .arg(sample.flags & PingSample::Udp ? "udp_seq" : "icmp_seq").arg(sample.sequence);
+    }
+    if(sample.ttl >= 0) {
+        text += QString(" ttl=%1").arg(sample.ttl);
+    }
+    double rtt = sample.rtt;
+    text += QString(" time=%1 ms").arg(rtt, 0, 'f', rtt < 1.0 ? 3 : (rtt < 100.0 ? 2 : 1));
+    if(sample.flags & PingSample::OneWay) {
+        text += QString(" fwd=%1 rev=%2 ms").arg(sample.forward, 0, 'f', 3).arg(sample.reverse, 0, 'f', 3);
+    }
+    if(sample.flags & PingSample::Duplicate) {
+        text += " (DUP!)";
+    } else if(sample.flags & PingSample::Late) {
+        text += " (late)";
+    } else if(sample.flags & PingSample::Reordered) {
+        text += " (reordered)";
+    }
+    return text;
+}
+
+}
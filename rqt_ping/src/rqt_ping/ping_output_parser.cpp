@@ -0,0 +1,160 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/ping_output_parser.h"
+
+#include <string.h>
+
+namespace {
+
+const int CarryReserve = 256;
+
+const char* find(const char* begin, const char* end, const char* key, const int& length)
+{
+    const void* p = memmem(begin, end - begin, key, length);
+    return p ? (const char*)p + length : nullptr;
+}
+
+bool parseInt(const char*& p, const char* end, int& value)
+{
+    const char* start = p;
+    value = 0;
+    while(p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        ++p;
+    }
+    return p != start;
+}
+
+// locale-independent, since ping always prints a '.' under LANG=C
+bool parseDouble(const char*& p, const char* end, double& value)
+{
+    int integer = 0;
+    if(!parseInt(p, end, integer)) {
+        return false;
+    }
+    value = (double)integer;
+    if(p < end && *p == '.') {
+        ++p;
+        double scale = 0.1;
+        while(p < end && *p >= '0' && *p <= '9') {
+            value += (double)(*p - '0') * scale;
+            scale *= 0.1;
+            ++p;
+        }
+    }
+    return true;
+}
+
+}
+
+namespace rqt_ping {
+
+PingOutputParser::PingOutputParser()
+{
+    carry.reserve(CarryReserve);
+    clear();
+}
+
+void PingOutputParser::clear()
+{
+    carry.clear();
+    num_lines = 0;
+    num_replies = 0;
+}
+
+void PingOutputParser::feed(const char* data, const int& size)
+{
+    const char* p = data;
+    const char* end = data + size;
+
+    if(!carry.empty()) {
+        const char* newline = (const char*)memchr(p, '\n', end - p);
+        if(!newline) {
+            carry.insert(carry.end(), p, end);
+            return;
+        }
+        carry.insert(carry.end(), p, newline);
+        parseLine(carry.data(), (int)carry.size());
+        carry.clear();
+        p = newline + 1;
+    }
+
+    // complete lines are parsed in place without copying
+    while(p < end) {
+        const char* newline = (const char*)memchr(p, '\n', end - p);
+        if(!newline) {
+            carry.insert(carry.end(), p, end);
+            break;
+        }
+        parseLine(p, (int)(newline - p));
+        p = newline + 1;
+    }
+}
+
+void PingOutputParser::finish()
+{
+    if(!carry.empty()) {
+        parseLine(carry.data(), (int)carry.size());
+        carry.clear();
+    }
+}
+
+void PingOutputParser::parseLine(const char* line, const int& length)
+{
+    int size = length;
+    if(size > 0 && line[size - 1] == '\r') {
+        --size;
+    }
+    if(size == 0) {
+        return;
+    }
+    ++num_lines;
+
+    PingReply reply;
+    if(parseReply(line, size, reply)) {
+        ++num_replies;
+        if(replyFunction) {
+            replyFunction(reply);
+        }
+    } else if(messageFunction) {
+        messageFunction(line, size);
+    }
+}
+
+bool PingOutputParser::parseReply(const char* line, const int& length, PingReply& reply)
+{
+    // 64 bytes from 127.0.0.1: icmp_seq=1 ttl=64 time=0.045 ms (DUP!)
+    const char* end = line + length;
+    const char* p = line;
+    if(!parseInt(p, end, reply.bytes) || !find(p, end, " bytes from ", 12)) {
+        return false;
+    }
+
+    p = find(p, end, "icmp_seq=", 9);
+    if(!p || !parseInt(p, end, reply.sequence)) {
+        return false;
+    }
+
+    const char* q = find(p, end, "ttl=", 4);
+    if(!q || !parseInt(q, end, reply.ttl)) {
+        reply.ttl = -1;
+    } else {
+        p = q;
+    }
+
+    p = find(p, end, "time", 4);
+    if(!p || p >= end || (*p != '=' && *p != '<')) {
+        return false;
+    }
+    ++p;
+    if(!parseDouble(p, end, reply.time)) {
+        return false;
+    }
+
+    reply.is_duplicate = find(p, end, "DUP!", 4) != nullptr;
+    return true;
+}
+
+}
@@ -0,0 +1,268 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/ping_worker.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+
+#include <utility>
+
+#include "rqt_ping/ping.h"
+
+namespace {
+
+enum Request { Create, Start, Stop, Destroy };
+
+// about two seconds of samples at 30k probes per second, beyond that the UI is not taking them
+const int MaxPendingSamples = 65536;
+
+}
+
+namespace rqt_ping {
+
+void PingRow::setStatistics(const RttStatistics& statistics)
+{
+    count = statistics.count();
+    min = statistics.min();
+    avg = statistics.avg();
+    max = statistics.max();
+    mdev = statistics.mdev();
+    p99 = statistics.percentile(99.0);
+}
+
+class PingWorker::Impl
+{
+public:
+    PingWorker* self;
+
+    Impl(PingWorker* self);
+    ~Impl();
+
+    void handle(const int& request);
+    void publishRows();
+    void bin(const PingSample& sample);
+
+    QThread thread;
+    QObject context;
+    Ping* ping;
+    QTimer* frameTimer;
+    QVector<bool> dirty;
+    bool is_started;
+
+    // shared with the UI thread
+    QMutex mutex;
+    PingDelta delta;
+    QVector<PingRow> rows;
+    QVector<bool> changed;
+    QStringList addresses;
+    int chart_target;
+};
+
+
+PingWorker::PingWorker(QObject* parent)
+    : QObject(parent)
+{
+    impl = new Impl(this);
+}
+
+PingWorker::Impl::Impl(PingWorker* self)
+    : self(self)
+{
+    ping = nullptr;
+    frameTimer = nullptr;
+    is_started = false;
+    delta.dropped = 0;
+    chart_target = 0;
+
+    context.moveToThread(&thread);
+    self->connect(self, &PingWorker::requested, &context, [&](int request){ handle(request); },
+        Qt::BlockingQueuedConnection);
+    thread.start();
+    emit self->requested(Create);
+}
+
+PingWorker::~PingWorker()
+{
+    delete impl;
+}
+
+PingWorker::Impl::~Impl()
+{
+    emit self->requested(Destroy);
+    thread.quit();
+    thread.wait();
+}
+
+Ping* PingWorker::ping() const
+{
+    return impl->ping;
+}
+
+void PingWorker::start()
+{
+    emit requested(Start);
+}
+
+void PingWorker::stop()
+{
+    emit requested(Stop);
+}
+
+bool PingWorker::started() const
+{
+    return impl->is_started;
+}
+
+QStringList PingWorker::addresses() const
+{
+    QMutexLocker locker(&impl->mutex);
+    return impl->addresses;
+}
+
+void PingWorker::setChartTarget(const int& index)
+{
+    QMutexLocker locker(&impl->mutex);
+    impl->chart_target = index;
+    impl->delta.chart_buckets.clear();
+}
+
+PingDelta PingWorker::takeDelta()
+{
+    PingDelta delta;
+    QMutexLocker locker(&impl->mutex);
+    std::swap(delta, impl->delta);
+    impl->delta.dropped = 0;
+    for(int i = 0; i < impl->changed.size(); ++i) {
+        if(impl->changed[i]) {
+            impl->changed[i] = false;
+            delta.indices << i;
+            delta.rows << impl->rows[i];
+        }
+    }
+    return delta;
+}
+
+void PingWorker::Impl::handle(const int& request)
+{
+    if(request == Create) {
+        // the timers and socket notifiers of the engine belong to the thread that creates them
+        ping = new Ping;
+        frameTimer = new QTimer;
+        self->connect(ping, &Ping::output, [&](QString text){
+            QMutexLocker locker(&mutex);
+            delta.lines << text;
+            delta.line_positions << delta.samples.size();
+        });
+        self->connect(ping, &Ping::sampled, [&](PingSample sample){
+            QMutexLocker locker(&mutex);
+            bin(sample);
+            if(delta.samples.size() < MaxPendingSamples) {
+                delta.samples.push_back(sample);
+            } else {
+                ++delta.dropped;
+            }
+        });
+        self->connect(ping, &Ping::targetUpdated, [&](int index){
+            if(index >= 0 && index < dirty.size()) {
+                dirty[index] = true;
+            }
+        });
+        self->connect(frameTimer, &QTimer::timeout, [&](){ publishRows(); });
+    } else if(request == Start) {
+        ping->start();
+        is_started = ping->started();
+
+        QStringList list;
+        for(int i = 0; i < ping->numTargets(); ++i) {
+            list << ping->address(i);
+        }
+        {
+            QMutexLocker locker(&mutex);
+            addresses = list;
+            rows.resize(list.size());
+            changed.fill(false, list.size());
+        }
+        dirty.fill(true, list.size());
+        publishRows();
+        frameTimer->start(FrameInterval);
+    } else if(request == Stop) {
+        frameTimer->stop();
+        ping->stop();
+        is_started = false;
+        // the probes still unanswered have just been counted as lost
+        dirty.fill(true);
+        publishRows();
+    } else if(request == Destroy) {
+        delete frameTimer;
+        delete ping;
+        frameTimer = nullptr;
+        ping = nullptr;
+    }
+}
+
+void PingWorker::Impl::bin(const PingSample& sample)
+{
+    // the chart is handed a bucket per level 0 width rather than every reply
+    if(sample.target != chart_target || (sample.flags & PingSample::Duplicate)) {
+        return;
+    }
+
+    qint64 start = sample.time - sample.time % RttPyramid::DefaultResolution;
+    QVector<RttPyramid::Bucket>& buckets = delta.chart_buckets;
+    if(buckets.isEmpty() || buckets.last().start != start) {
+        RttPyramid::Bucket bucket;
+        bucket.start = start;
+        bucket.min = (float)sample.rtt;
+        bucket.max = (float)sample.rtt;
+        bucket.sum = 0.0;
+        bucket.count = 0;
+        bucket.transmitted = 0;
+        bucket.received = 0;
+        buckets.push_back(bucket);
+    }
+
+    RttPyramid::Bucket& bucket = buckets.last();
+    bucket.min = qMin(bucket.min, (float)sample.rtt);
+    bucket.max = qMax(bucket.max, (float)sample.rtt);
+    bucket.sum += sample.rtt;
+    ++bucket.count;
+}
+
+void PingWorker::Impl::publishRows()
+{
+    // the rows are built once per frame rather than per sample, the percentile is the costly part
+    QVector<int> indices;
+    QVector<PingRow> updates;
+    for(int i = 0; i < dirty.size(); ++i) {
+        if(dirty[i]) {
+            dirty[i] = false;
+            PingRow row;
+            row.transmitted = ping->transmittedPackets(i);
+            row.received = ping->receivedPackets(i);
+            row.loss = ping->loss(i);
+            row.duplicates = ping->duplicatePackets(i);
+            row.reordered = ping->reorderedPackets(i);
+            row.late = ping->latePackets(i);
+            row.last = ping->lastRtt(i);
+            row.setStatistics(ping->statistics(i));
+            row.responder = ping->responder(i);
+            row.beyond = ping->beyondDestination(i);
+            indices << i;
+            updates << row;
+        }
+    }
+
+    QMutexLocker locker(&mutex);
+    for(int i = 0; i < indices.size(); ++i) {
+        if(indices[i] < rows.size()) {
+            rows[indices[i]] = updates[i];
+            changed[indices[i]] = true;
+        }
+    }
+}
+
+}
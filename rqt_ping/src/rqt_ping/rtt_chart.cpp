@@ -0,0 +1,194 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/rtt_chart.h"
+
+#include <QDateTime>
+#include <QPainter>
+#include <QPolygonF>
+#include <QTimer>
+
+#include <vector>
+
+namespace {
+
+const int RefreshInterval = 100;
+const int Margin = 40;
+
+}
+
+namespace rqt_ping {
+
+class RttChart::Impl
+{
+public:
+    RttChart* self;
+
+    Impl(RttChart* self);
+
+    void paint(QPainter& painter);
+
+    RttPyramid pyramid;
+    QTimer refreshTimer;
+    std::vector<RttPyramid::Bucket> buckets;
+    double span;
+    bool is_dirty;
+};
+
+
+RttChart::RttChart(QWidget* parent)
+    : QWidget(parent)
+{
+    impl = new Impl(this);
+}
+
+RttChart::Impl::Impl(RttChart* self)
+    : self(self)
+{
+    span = 60.0;
+    is_dirty = false;
+
+    self->setMinimumSize(320, 160);
+    self->setAutoFillBackground(true);
+    self->setBackgroundRole(QPalette::Base);
+
+    // samples only touch the pyramid, painting happens at a fixed rate when something changed
+    self->connect(&refreshTimer, &QTimer::timeout, [&](){
+        if(is_dirty) {
+            is_dirty = false;
+            self->update();
+        }
+    });
+    refreshTimer.start(RefreshInterval);
+}
+
+RttChart::~RttChart()
+{
+    delete impl;
+}
+
+void RttChart::addSample(const PingSample& sample)
+{
+    impl->pyramid.add(sample.time, sample.rtt);
+    impl->is_dirty = true;
+}
+
+void RttChart::addBuckets(const QVector<RttPyramid::Bucket>& buckets)
+{
+    for(const RttPyramid::Bucket& bucket : buckets) {
+        impl->pyramid.addBucket(bucket);
+    }
+    if(!buckets.isEmpty()) {
+        impl->is_dirty = true;
+    }
+}
+
+void RttChart::addCounts(const int& transmitted, const int& received)
+{
+    impl->pyramid.addCounts(QDateTime::currentMSecsSinceEpoch() * 1000, transmitted, received);
+    impl->is_dirty = true;
+}
+
+void RttChart::clear()
+{
+    impl->pyramid.clear();
+    impl->is_dirty = true;
+}
+
+void RttChart::setSpan(const double& second)
+{
+    impl->span = second;
+    impl->is_dirty = true;
+}
+
+double RttChart::span() const
+{
+    return impl->span;
+}
+
+void RttChart::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(this);
+    impl->paint(painter);
+}
+
+void RttChart::Impl::paint(QPainter& painter)
+{
+    QRectF area(Margin, Margin / 2, self->width() - Margin * 2, self->height() - Margin * 3 / 2);
+    if(area.width() <= 0.0 || area.height() <= 0.0) {
+        return;
+    }
+
+    painter.setPen(self->palette().color(QPalette::Mid));
+    painter.drawRect(area);
+    if(pyramid.isEmpty()) {
+        return;
+    }
+
+    // pick the finest level that still yields at most about one bucket per pixel
+    qint64 to = pyramid.lastTime();
+    qint64 length = span > 0.0 ? (qint64)(span * 1000000.0) : qMax(to - pyramid.firstTime(), (qint64)1000000);
+    qint64 from = to - length;
+    int level = pyramid.selectLevel(length, (int)area.width());
+    pyramid.buckets(level, from, to, buckets);
+    if(buckets.empty()) {
+        return;
+    }
+
+    double top = 0.0;
+    for(size_t i = 0; i < buckets.size(); ++i) {
+        if(buckets[i].count) {
+            top = qMax(top, (double)buckets[i].max);
+        }
+    }
+    top = top > 0.0 ? top * 1.1 : 1.0;
+
+    auto x = [&](const qint64& time) {
+        return area.left() + area.width() * (double)(time - from) / (double)length;
+    };
+    auto y = [&](const double& rtt) {
+        return area.bottom() - area.height() * rtt / top;
+    };
+    double width = qMax(1.0, area.width() * (double)pyramid.width(level) / (double)length);
+
+    // loss as bars from the bottom, scaled to 100 %
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(220, 60, 60, 90));
+    for(size_t i = 0; i < buckets.size(); ++i) {
+        double loss = buckets[i].loss();
+        if(loss > 0.0) {
+            double height = area.height() * loss / 100.0;
+            painter.drawRect(QRectF(x(buckets[i].start), area.bottom() - height, width, height));
+        }
+    }
+
+    // min/max envelope and mean line
+    painter.setBrush(QColor(60, 120, 220, 70));
+    QPolygonF means;
+    for(size_t i = 0; i < buckets.size(); ++i) {
+        const RttPyramid::Bucket& bucket = buckets[i];
+        if(bucket.count == 0) {
+            continue;
+        }
+        double left = x(bucket.start);
+        painter.drawRect(QRectF(left, y(bucket.max), width, qMax(1.0, y(bucket.min) - y(bucket.max))));
+        means << QPointF(left + width / 2.0, y(bucket.mean()));
+    }
+    painter.setPen(QPen(QColor(30, 80, 200), 1.5));
+    painter.drawPolyline(means);
+
+    painter.setPen(self->palette().color(QPalette::Text));
+    painter.drawText(QRectF(0, area.top() - Margin / 2, Margin * 2, Margin / 2),
+        Qt::AlignLeft | Qt::AlignVCenter, QString("%1 ms").arg(top, 0, 'g', 3));
+    painter.drawText(QRectF(0, area.bottom() - Margin / 4, Margin - 4, Margin / 2),
+        Qt::AlignRight | Qt::AlignVCenter, "0");
+    painter.drawText(QRectF(area.right() - Margin * 2, area.top() - Margin / 2, Margin * 2, Margin / 2),
+        Qt::AlignRight | Qt::AlignVCenter, "loss 100 %");
+    painter.drawText(QRectF(area.left(), area.bottom(), area.width(), Margin),
+        Qt::AlignHCenter | Qt::AlignVCenter,
+        QString("last %1 s  (%2 ms buckets)").arg((double)length / 1000000.0, 0, 'f', 0)
+            .arg((double)pyramid.width(level) / 1000.0, 0, 'f', 0));
+}
+
+}
@@ -0,0 +1,143 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/rtt_pyramid.h"
+
+namespace rqt_ping {
+
+RttPyramid::RttPyramid(const qint64& resolution, const int& numLevels, const int& capacity, const int& factor)
+{
+    qint64 width = resolution;
+    for(int i = 0; i < numLevels; ++i) {
+        Level level;
+        level.width = width;
+        level.ring.resize(capacity);
+        levels.push_back(level);
+        width *= factor;
+    }
+    clear();
+}
+
+void RttPyramid::clear()
+{
+    for(size_t i = 0; i < levels.size(); ++i) {
+        std::vector<Bucket>& ring = levels[i].ring;
+        for(size_t j = 0; j < ring.size(); ++j) {
+            ring[j].start = -1;
+        }
+    }
+    first = -1;
+    last = -1;
+    last_transmitted = 0;
+    last_received = 0;
+}
+
+RttPyramid::Bucket& RttPyramid::bucket(Level& level, const qint64& time)
+{
+    // a slot is recycled as soon as a newer bucket maps onto it
+    qint64 start = time - time % level.width;
+    Bucket& bucket = level.ring[(start / level.width) % (qint64)level.ring.size()];
+    if(bucket.start != start) {
+        bucket.start = start;
+        bucket.min = 0.0f;
+        bucket.max = 0.0f;
+        bucket.sum = 0.0;
+        bucket.count = 0;
+        bucket.transmitted = 0;
+        bucket.received = 0;
+    }
+    return bucket;
+}
+
+void RttPyramid::add(const qint64& time, const double& rtt)
+{
+    for(size_t i = 0; i < levels.size(); ++i) {
+        Bucket& b = bucket(levels[i], time);
+        if(b.count == 0 || rtt < b.min) {
+            b.min = (float)rtt;
+        }
+        if(b.count == 0 || rtt > b.max) {
+            b.max = (float)rtt;
+        }
+        b.sum += rtt;
+        ++b.count;
+    }
+    if(first < 0) {
+        first = time;
+    }
+    last = qMax(last, time);
+}
+
+void RttPyramid::addBucket(const Bucket& bucket)
+{
+    if(bucket.count == 0) {
+        return;
+    }
+
+    for(size_t i = 0; i < levels.size(); ++i) {
+        Bucket& b = this->bucket(levels[i], bucket.start);
+        if(b.count == 0 || bucket.min < b.min) {
+            b.min = bucket.min;
+        }
+        if(b.count == 0 || bucket.max > b.max) {
+            b.max = bucket.max;
+        }
+        b.sum += bucket.sum;
+        b.count += bucket.count;
+    }
+    if(first < 0) {
+        first = bucket.start;
+    }
+    last = qMax(last, bucket.start);
+}
+
+void RttPyramid::addCounts(const qint64& time, const int& transmitted, const int& received)
+{
+    // the counters are cumulative, only their increments are binned
+    int transmitted_delta = transmitted - last_transmitted;
+    int received_delta = received - last_received;
+    last_transmitted = transmitted;
+    last_received = received;
+    if(transmitted_delta <= 0 && received_delta <= 0) {
+        return;
+    }
+
+    for(size_t i = 0; i < levels.size(); ++i) {
+        Bucket& b = bucket(levels[i], time);
+        b.transmitted += qMax(0, transmitted_delta);
+        b.received += qMax(0, received_delta);
+    }
+    if(first < 0) {
+        first = time;
+    }
+    last = qMax(last, time);
+}
+
+int RttPyramid::selectLevel(const qint64& span, const int& maxBuckets) const
+{
+    for(size_t i = 0; i < levels.size(); ++i) {
+        const Level& level = levels[i];
+        qint64 covered = level.width * (qint64)level.ring.size();
+        if(span / level.width <= maxBuckets && span <= covered) {
+            return (int)i;
+        }
+    }
+    return (int)levels.size() - 1;
+}
+
+void RttPyramid::buckets(const int& level, const qint64& from, const qint64& to, std::vector<Bucket>& out) const
+{
+    out.clear();
+    const Level& l = levels[level];
+    qint64 size = (qint64)l.ring.size();
+    qint64 first = qMax(from / l.width, to / l.width - size + 1);
+    for(qint64 index = first; index <= to / l.width; ++index) {
+        const Bucket& b = l.ring[index % size];
+        if(b.start == index * l.width) {
+            out.push_back(b);
+        }
+    }
+}
+
+}
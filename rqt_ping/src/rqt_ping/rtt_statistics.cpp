@@ -0,0 +1,83 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/rtt_statistics.h"
+
+#include <QtMath>
+
+#include <cmath>
+#include <string.h>
+
+namespace {
+
+const double LowerBound = 0.001;
+
+}
+
+namespace rqt_ping {
+
+RttStatistics::RttStatistics()
+{
+    clear();
+}
+
+void RttStatistics::clear()
+{
+    n = 0;
+    mean = 0.0;
+    m2 = 0.0;
+    min_ = 0.0;
+    max_ = 0.0;
+    memset(buckets, 0, sizeof(buckets));
+}
+
+void RttStatistics::add(const double& rtt)
+{
+    // Welford's online update keeps mean and variance numerically stable in O(1)
+    ++n;
+    double delta = rtt - mean;
+    mean += delta / (double)n;
+    m2 += delta * (rtt - mean);
+
+    if(n == 1 || rtt < min_) {
+        min_ = rtt;
+    }
+    if(n == 1 || rtt > max_) {
+        max_ = rtt;
+    }
+
+    int index = 0;
+    if(rtt > LowerBound) {
+        index = (int)(std::log10(rtt / LowerBound) * (double)BucketsPerDecade);
+    }
+    buckets[qBound(0, index, (int)NumBuckets - 1)]++;
+}
+
+double RttStatistics::mdev() const
+{
+    return n ? qSqrt(m2 / (double)n) : 0.0;
+}
+
+double RttStatistics::percentile(const double& p) const
+{
+    if(n == 0) {
+        return 0.0;
+    }
+
+    quint64 rank = (quint64)qCeil(p / 100.0 * (double)n);
+    rank = qBound((quint64)1, rank, n);
+
+    quint64 sum = 0;
+    for(int i = 0; i < NumBuckets; ++i) {
+        sum += buckets[i];
+        if(sum >= rank) {
+            // report the geometric center of the bucket, clamped to the observed range
+            double value = LowerBound * qPow(10.0, ((double)i + 0.5) / (double)BucketsPerDecade);
+            return qBound(min_, value, max_);
+        }
+    }
+    return max_;
+}
+
+}
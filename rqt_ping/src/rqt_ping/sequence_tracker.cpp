@@ -0,0 +1,184 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/sequence_tracker.h"
+
+namespace {
+
+const int MaxWindowSize = 65536 / 2;
+
+}
+
+namespace rqt_ping {
+
+SequenceTracker::SequenceTracker(const int& windowSize)
+{
+    setWindowSize(windowSize);
+}
+
+void SequenceTracker::setWindowSize(const int& windowSize)
+{
+    // half of the 16-bit sequence space at most, so wrapped sequences stay unambiguous
+    int size = 1;
+    while(size < windowSize && size < MaxWindowSize) {
+        size <<= 1;
+    }
+    entries.resize(size);
+    mask = size - 1;
+    clear();
+}
+
+void SequenceTracker::clear()
+{
+    for(size_t i = 0; i < entries.size(); ++i) {
+        entries[i].time = 0;
+        entries[i].sequence = 0;
+        entries[i].state = Empty;
+    }
+    highest_sent = -1;
+    highest_received = -1;
+    next_outcome = -1;
+    pending_ = 0;
+    lost_ = 0;
+    duplicates_ = 0;
+    reordered_ = 0;
+    late_ = 0;
+}
+
+void SequenceTracker::sent(const quint16& sequence, const qint64& time)
+{
+    // sequences are extended to 64 bits, so the 16-bit wrap-around is invisible from here on
+    qint64 extended = highest_sent < 0 ? sequence
+        : highest_sent + (quint16)(sequence - (quint16)highest_sent);
+    if(next_outcome < 0) {
+        next_outcome = extended;
+    }
+    Entry& entry = entries[extended & mask];
+    if(entry.state == Pending) {
+        // the window is smaller than the probes in flight, the oldest one is given up
+        entry.state = Lost;
+        --pending_;
+        ++lost_;
+    }
+    if(entry.state != Empty) {
+        advance();
+    }
+    entry.time = time;
+    entry.sequence = sequence;
+    entry.state = Pending;
+    ++pending_;
+    highest_sent = extended;
+}
+
+void SequenceTracker::setSentTime(const quint16& sequence, const qint64& time)
+{
+    Entry* entry = find(sequence);
+    if(entry) {
+        entry->time = time;
+    }
+}
+
+qint64 SequenceTracker::sentTime(const quint16& sequence) const
+{
+    const Entry* entry = find(sequence);
+    return entry ? entry->time : -1;
+}
+
+SequenceTracker::Result SequenceTracker::received(const quint16& sequence)
+{
+    Entry* entry = find(sequence);
+    if(!entry) {
+        return Unknown;
+    }
+
+    qint64 extended = highest_sent - (quint16)((quint16)highest_sent - sequence);
+    switch(entry->state) {
+    case Pending:
+        entry->state = Received;
+        --pending_;
+        advance();
+        if(extended < highest_received) {
+            ++reordered_;
+            return Reordered;
+        }
+        highest_received = extended;
+        return InOrder;
+    case Lost:
+        entry->state = Received;
+        --lost_;
+        ++late_;
+        if(extended > highest_received) {
+            highest_received = extended;
+        }
+        return Late;
+    case Received:
+        ++duplicates_;
+        return Duplicate;
+    default:
+        return Unknown;
+    }
+}
+
+bool SequenceTracker::expire(const quint16& sequence)
+{
+    Entry* entry = find(sequence);
+    if(!entry || entry->state != Pending) {
+        return false;
+    }
+    entry->state = Lost;
+    --pending_;
+    ++lost_;
+    advance();
+    return true;
+}
+
+void SequenceTracker::finish()
+{
+    for(size_t i = 0; i < entries.size(); ++i) {
+        if(entries[i].state == Pending) {
+            entries[i].state = Lost;
+            ++lost_;
+        }
+    }
+    pending_ = 0;
+    advance();
+}
+
+void SequenceTracker::advance()
+{
+    while(next_outcome >= 0 && next_outcome <= highest_sent) {
+        const Entry& entry = entries[next_outcome & mask];
+        if(entry.state == Pending) {
+            break;
+        }
+        if(outcomeFunction && entry.state != Empty) {
+            outcomeFunction(entry.state == Received);
+        }
+        ++next_outcome;
+    }
+}
+
+SequenceTracker::Entry* SequenceTracker::find(const quint16& sequence)
+{
+    return const_cast<Entry*>(static_cast<const SequenceTracker*>(this)->find(sequence));
+}
+
+const SequenceTracker::Entry* SequenceTracker::find(const quint16& sequence) const
+{
+    if(highest_sent < 0) {
+        return nullptr;
+    }
+    // only sequences at or behind the latest one sent and within the window are known
+    qint64 distance = (quint16)((quint16)highest_sent - sequence);
+    if(distance > mask) {
+        return nullptr;
+    }
+    const Entry& entry = entries[(highest_sent - distance) & mask];
+    if(entry.state == Empty || entry.sequence != sequence) {
+        return nullptr;
+    }
+    return &entry;
+}
+
+}
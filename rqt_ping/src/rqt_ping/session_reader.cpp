@@ -0,0 +1,375 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/session_reader.h"
+
+#include <QFile>
+#include <QVector>
+
+#include <string.h>
+
+#include "rqt_ping/session_format.h"
+
+namespace rqt_ping {
+
+struct SessionBlock {
+    const uchar* data;  // first column, right behind the block header
+    quint32 count;
+    qint64 first_time;
+    qint64 last_time;
+    quint64 first_sample;
+};
+
+struct SessionTarget {
+    QString address;
+    int transmitted;
+    int lost;
+};
+
+class SessionReader::Impl
+{
+public:
+    Impl();
+
+    bool readIndex(const SessionTrailer& trailer);
+    void scanBlocks();
+    void addBlock(const quint64& offset, const SessionBlockHeader& header);
+
+    QFile file;
+    const uchar* data;
+    quint64 size;
+    bool is_complete;
+    SessionFileHeader header;
+    QVector<SessionBlock> blocks;
+    QVector<SessionTarget> targets;
+    quint64 num_samples;
+};
+
+
+SessionReader::SessionReader()
+{
+    impl = new Impl;
+}
+
+SessionReader::Impl::Impl()
+{
+    data = nullptr;
+    size = 0;
+    is_complete = false;
+    num_samples = 0;
+    memset(&header, 0, sizeof(header));
+}
+
+SessionReader::~SessionReader()
+{
+    close();
+    delete impl;
+}
+
+bool SessionReader::open(const QString& fileName)
+{
+    close();
+
+    impl->file.setFileName(fileName);
+    if(!impl->file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    impl->size = impl->file.size();
+    if(impl->size < sizeof(SessionFileHeader)) {
+        close();
+        return false;
+    }
+    // the pages are only touched as the columns are read
+    impl->data = impl->file.map(0, impl->size);
+    if(!impl->data) {
+        close();
+        return false;
+    }
+    memcpy(&impl->header, impl->data, sizeof(impl->header));
+    if(memcmp(impl->header.magic, SessionMagic, sizeof(SessionMagic)) != 0
+            || impl->header.version != SessionVersion) {
+        close();
+        return false;
+    }
+
+    SessionTrailer trailer;
+    impl->is_complete = false;
+    if(impl->size >= sizeof(SessionFileHeader) + sizeof(trailer)) {
+        memcpy(&trailer, impl->data + impl->size - sizeof(trailer), sizeof(trailer));
+        impl->is_complete = memcmp(trailer.magic, SessionEndMagic, sizeof(SessionEndMagic)) == 0
+            && impl->readIndex(trailer);
+    }
+    if(!impl->is_complete) {
+        impl->scanBlocks();
+    }
+    return true;
+}
+
+void SessionReader::close()
+{
+    if(impl->data) {
+        impl->file.unmap(const_cast<uchar*>(impl->data));
+        impl->data = nullptr;
+    }
+    impl->file.close();
+    impl->size = 0;
+    impl->blocks.clear();
+    impl->targets.clear();
+    impl->num_samples = 0;
+}
+
+bool SessionReader::isOpen() const
+{
+    return impl->data != nullptr;
+}
+
+bool SessionReader::isComplete() const
+{
+    return impl->is_complete;
+}
+
+qint64 SessionReader::startTime() const
+{
+    return impl->header.start_time;
+}
+
+int SessionReader::mode() const
+{
+    return (int)impl->header.mode;
+}
+
+int SessionReader::numTargets() const
+{
+    return impl->targets.size();
+}
+
+QString SessionReader::address(const int& index) const
+{
+    return impl->targets[index].address;
+}
+
+int SessionReader::transmittedPackets(const int& index) const
+{
+    return impl->targets[index].transmitted;
+}
+
+int SessionReader::lostPackets(const int& index) const
+{
+    return impl->targets[index].lost;
+}
+
+quint64 SessionReader::numSamples() const
+{
+    return impl->num_samples;
+}
+
+PingSample SessionReader::sample(const quint64& index) const
+{
+    // every block but the last is full, so the block follows from the index
+    int block = impl->header.block_size > 0 ? (int)(index / impl->header.block_size) : 0;
+    block = qMin(block, impl->blocks.size() - 1);
+    while(block > 0 && impl->blocks[block].first_sample > index) {
+        --block;
+    }
+    // a damaged file may have short blocks in between
+    while(block + 1 < impl->blocks.size() && impl->blocks[block].first_sample + impl->blocks[block].count <= index) {
+        ++block;
+    }
+    int i = (int)(index - impl->blocks[block].first_sample);
+
+    PingSample sample;
+    sample.time = times(block)[i];
+    sample.rtt = rtts(block)[i];
+    sample.forward = forwards(block)[i];
+    sample.reverse = reverses(block)[i];
+    sample.target = targets(block)[i];
+    sample.sequence = sequences(block)[i];
+    sample.flags = flags(block)[i];
+    sample.ttl = ttls(block)[i];
+    sample.bytes = bytes(block)[i];
+    return sample;
+}
+
+int SessionReader::numBlocks() const
+{
+    return impl->blocks.size();
+}
+
+int SessionReader::blockSize(const int& block) const
+{
+    return (int)impl->blocks[block].count;
+}
+
+qint64 SessionReader::firstTime(const int& block) const
+{
+    return impl->blocks[block].first_time;
+}
+
+qint64 SessionReader::lastTime(const int& block) const
+{
+    return impl->blocks[block].last_time;
+}
+
+int SessionReader::findBlock(const qint64& time) const
+{
+    int low = 0;
+    int high = impl->blocks.size();
+    while(low < high) {
+        int middle = (low + high) / 2;
+        if(impl->blocks[middle].last_time < time) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+const qint64* SessionReader::times(const int& block) const
+{
+    return (const qint64*)impl->blocks[block].data;
+}
+
+const float* SessionReader::rtts(const int& block) const
+{
+    const SessionBlock& b = impl->blocks[block];
+    return (const float*)(b.data + 8 * b.count);
+}
+
+const float* SessionReader::forwards(const int& block) const
+{
+    const SessionBlock& b = impl->blocks[block];
+    return (const float*)(b.data + 12 * b.count);
+}
+
+const float* SessionReader::reverses(const int& block) const
+{
+    const SessionBlock& b = impl->blocks[block];
+    return (const float*)(b.data + 16 * b.count);
+}
+
+const qint32* SessionReader::targets(const int& block) const
+{
+    const SessionBlock& b = impl->blocks[block];
+    return (const qint32*)(b.data + 20 * b.count);
+}
+
+const quint16* SessionReader::sequences(const int& block) const
+{
+    const SessionBlock& b = impl->blocks[block];
+    return (const quint16*)(b.data + 24 * b.count);
+}
+
+const quint16* SessionReader::flags(const int& block) const
+{
+    const SessionBlock& b = impl->blocks[block];
+    return (const quint16*)(b.data + 26 * b.count);
+}
+
+const qint16* SessionReader::ttls(const int& block) const
+{
+    const SessionBlock& b = impl->blocks[block];
+    return (const qint16*)(b.data + 28 * b.count);
+}
+
+const quint16* SessionReader::bytes(const int& block) const
+{
+    const SessionBlock& b = impl->blocks[block];
+    return (const quint16*)(b.data + 30 * b.count);
+}
+
+bool SessionReader::Impl::readIndex(const SessionTrailer& trailer)
+{
+    quint64 trailer_offset = size - sizeof(trailer);
+    if(trailer.targets_offset + (quint64)trailer.num_targets * sizeof(SessionTargetEntry) > trailer_offset
+            || trailer.index_offset + (quint64)trailer.num_blocks * sizeof(SessionIndexEntry) > trailer_offset) {
+        return false;
+    }
+
+    targets.resize(trailer.num_targets);
+    for(quint32 i = 0; i < trailer.num_targets; ++i) {
+        SessionTargetEntry entry;
+        memcpy(&entry, data + trailer.targets_offset + i * sizeof(entry), sizeof(entry));
+        entry.address[SessionAddressLength - 1] = '\0';
+        targets[i].address = QString::fromUtf8(entry.address);
+        targets[i].transmitted = (int)entry.transmitted;
+        targets[i].lost = (int)entry.lost;
+    }
+
+    for(quint32 i = 0; i < trailer.num_blocks; ++i) {
+        SessionIndexEntry entry;
+        memcpy(&entry, data + trailer.index_offset + i * sizeof(entry), sizeof(entry));
+        if(entry.offset < sizeof(SessionFileHeader) || entry.count == 0 || entry.count > header.block_size
+                || entry.offset + sessionBlockLength(entry.count) > trailer.targets_offset) {
+            blocks.clear();
+            return false;
+        }
+        // the columns are laid out by the count of the block, which has to be the one of the index
+        SessionBlockHeader block;
+        memcpy(&block, data + entry.offset, sizeof(block));
+        if(block.magic != SessionBlockMagic || block.count != entry.count) {
+            blocks.clear();
+            return false;
+        }
+        addBlock(entry.offset, block);
+    }
+    return true;
+}
+
+void SessionReader::Impl::scanBlocks()
+{
+    // without the trailer the blocks are walked until one is cut off
+    blocks.clear();
+    num_samples = 0;
+    quint64 offset = sizeof(SessionFileHeader);
+    while(offset + sizeof(SessionBlockHeader) <= size) {
+        SessionBlockHeader block;
+        memcpy(&block, data + offset, sizeof(block));
+        if(block.magic != SessionBlockMagic || block.count == 0 || block.count > header.block_size
+                || offset + sessionBlockLength(block.count) > size) {
+            break;
+        }
+        addBlock(offset, block);
+        offset += sessionBlockLength(block.count);
+    }
+
+    // every target that shows up in the samples, with nothing known about its losses; an index
+    // beyond one target per slot of the blocks can only come from a damaged file
+    targets.clear();
+    quint64 max_targets = (quint64)header.block_size * blocks.size();
+    for(const SessionBlock& b : blocks) {
+        const qint32* indices = (const qint32*)(b.data + 20 * b.count);
+        for(quint32 i = 0; i < b.count; ++i) {
+            int index = indices[i];
+            if(index < 0 || (quint64)index >= max_targets) {
+                continue;
+            }
+            while(targets.size() <= index) {
+                SessionTarget target;
+                target.address = QString("target %1").arg(targets.size());
+                target.transmitted = 0;
+                target.lost = 0;
+                targets.push_back(target);
+            }
+            const quint16* flags = (const quint16*)(b.data + 26 * b.count);
+            if(!(flags[i] & PingSample::Duplicate)) {
+                ++targets[index].transmitted;
+            }
+        }
+    }
+}
+
+void SessionReader::Impl::addBlock(const quint64& offset, const SessionBlockHeader& header)
+{
+    SessionBlock block;
+    block.data = data + offset + sizeof(SessionBlockHeader);
+    block.count = header.count;
+    block.first_time = header.first_time;
+    block.last_time = header.last_time;
+    block.first_sample = num_samples;
+    blocks.push_back(block);
+    num_samples += header.count;
+}
+
+}
@@ -0,0 +1,212 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/session_writer.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QVector>
+
+#include <string.h>
+
+#include "rqt_ping/session_format.h"
+
+namespace rqt_ping {
+
+class SessionWriter::Impl
+{
+public:
+    Impl();
+
+    template<typename T> void writeColumn(const QVector<T>& column);
+    void writeBlock();
+
+    QFile file;
+    int block_size;
+    int count;
+    quint64 num_samples;
+    QVector<SessionTargetEntry> target_entries;
+    QVector<SessionIndexEntry> index;
+
+    // the columns of the block being filled
+    QVector<qint64> times;
+    QVector<float> rtts;
+    QVector<float> forwards;
+    QVector<float> reverses;
+    QVector<qint32> targets;
+    QVector<quint16> sequences;
+    QVector<quint16> flags;
+    QVector<qint16> ttls;
+    QVector<quint16> bytes;
+};
+
+
+SessionWriter::SessionWriter()
+{
+    impl = new Impl;
+}
+
+SessionWriter::Impl::Impl()
+{
+    block_size = DefaultBlockSize;
+    count = 0;
+    num_samples = 0;
+}
+
+SessionWriter::~SessionWriter()
+{
+    close();
+    delete impl;
+}
+
+bool SessionWriter::open(const QString& fileName, const QStringList& addresses, const int& mode,
+    const int& blockSize)
+{
+    close();
+
+    impl->file.setFileName(fileName);
+    if(!impl->file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    impl->block_size = qMax(1, blockSize);
+    impl->count = 0;
+    impl->num_samples = 0;
+    impl->index.clear();
+    impl->target_entries.resize(addresses.size());
+    for(int i = 0; i < addresses.size(); ++i) {
+        SessionTargetEntry& entry = impl->target_entries[i];
+        memset(&entry, 0, sizeof(entry));
+        strncpy(entry.address, addresses[i].toUtf8().constData(), SessionAddressLength - 1);
+    }
+
+    impl->times.resize(impl->block_size);
+    impl->rtts.resize(impl->block_size);
+    impl->forwards.resize(impl->block_size);
+    impl->reverses.resize(impl->block_size);
+    impl->targets.resize(impl->block_size);
+    impl->sequences.resize(impl->block_size);
+    impl->flags.resize(impl->block_size);
+    impl->ttls.resize(impl->block_size);
+    impl->bytes.resize(impl->block_size);
+
+    SessionFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SessionMagic, sizeof(header.magic));
+    header.version = SessionVersion;
+    header.block_size = (quint32)impl->block_size;
+    header.start_time = QDateTime::currentMSecsSinceEpoch() * 1000;
+    header.mode = (quint32)mode;
+    impl->file.write((const char*)&header, sizeof(header));
+    return true;
+}
+
+bool SessionWriter::isOpen() const
+{
+    return impl->file.isOpen();
+}
+
+QString SessionWriter::errorString() const
+{
+    return impl->file.errorString();
+}
+
+void SessionWriter::append(const PingSample& sample)
+{
+    if(!impl->file.isOpen()) {
+        return;
+    }
+
+    int i = impl->count++;
+    impl->times[i] = sample.time;
+    impl->rtts[i] = (float)sample.rtt;
+    impl->forwards[i] = (float)sample.forward;
+    impl->reverses[i] = (float)sample.reverse;
+    impl->targets[i] = sample.target;
+    impl->sequences[i] = sample.sequence;
+    impl->flags[i] = sample.flags;
+    impl->ttls[i] = sample.ttl;
+    impl->bytes[i] = sample.bytes;
+    if(impl->count == impl->block_size) {
+        impl->writeBlock();
+    }
+}
+
+void SessionWriter::setCounts(const int& index, const int& transmitted, const int& lost)
+{
+    if(index < impl->target_entries.size()) {
+        impl->target_entries[index].transmitted = (quint32)transmitted;
+        impl->target_entries[index].lost = (quint32)lost;
+    }
+}
+
+bool SessionWriter::close()
+{
+    if(!impl->file.isOpen()) {
+        return false;
+    }
+    if(impl->count > 0) {
+        impl->writeBlock();
+    }
+
+    SessionTrailer trailer;
+    memset(&trailer, 0, sizeof(trailer));
+    trailer.targets_offset = impl->file.pos();
+    trailer.num_targets = (quint32)impl->target_entries.size();
+    impl->file.write((const char*)impl->target_entries.constData(),
+        impl->target_entries.size() * sizeof(SessionTargetEntry));
+    trailer.index_offset = impl->file.pos();
+    trailer.num_blocks = (quint32)impl->index.size();
+    impl->file.write((const char*)impl->index.constData(), impl->index.size() * sizeof(SessionIndexEntry));
+    trailer.num_samples = impl->num_samples;
+    memcpy(trailer.magic, SessionEndMagic, sizeof(trailer.magic));
+    impl->file.write((const char*)&trailer, sizeof(trailer));
+
+    bool is_ok = impl->file.error() == QFileDevice::NoError;
+    impl->file.close();
+    return is_ok;
+}
+
+template<typename T> void SessionWriter::Impl::writeColumn(const QVector<T>& column)
+{
+    file.write((const char*)column.constData(), count * sizeof(T));
+}
+
+void SessionWriter::Impl::writeBlock()
+{
+    SessionIndexEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.offset = file.pos();
+    entry.count = (quint32)count;
+    entry.first_time = times[0];
+    entry.last_time = times[count - 1];
+    index.push_back(entry);
+
+    SessionBlockHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SessionBlockMagic;
+    header.count = (quint32)count;
+    header.first_time = entry.first_time;
+    header.last_time = entry.last_time;
+    file.write((const char*)&header, sizeof(header));
+
+    writeColumn(times);
+    writeColumn(rtts);
+    writeColumn(forwards);
+    writeColumn(reverses);
+    writeColumn(targets);
+    writeColumn(sequences);
+    writeColumn(flags);
+    writeColumn(ttls);
+    writeColumn(bytes);
+
+    static const char padding[8] = { 0 };
+    quint64 length = sizeof(header) + (quint64)count * SessionSampleSize;
+    file.write(padding, sessionBlockLength(count) - length);
+
+    num_samples += count;
+    count = 0;
+}
+
+}
@@ -0,0 +1,210 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/shm_stats_writer.h"
+
+#include <QDateTime>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <new>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rqt_ping {
+
+class ShmStatsWriter::Impl
+{
+public:
+    Impl();
+
+    QString name;
+    ShmHeader* header;
+    size_t size;
+    dev_t device;   // of the segment created, the name is only unlinked while it is still that one
+    ino_t inode;
+};
+
+
+ShmStatsWriter::ShmStatsWriter()
+{
+    impl = new Impl;
+}
+
+ShmStatsWriter::Impl::Impl()
+{
+    header = nullptr;
+    size = 0;
+    device = 0;
+    inode = 0;
+}
+
+ShmStatsWriter::~ShmStatsWriter()
+{
+    close();
+    delete impl;
+}
+
+bool ShmStatsWriter::open(const QString& name, const int& maxTargets, const int& ringSize)
+{
+    close();
+
+    quint32 ring_size = 1;
+    while(ring_size < (quint32)qMax(1, ringSize)) {
+        ring_size <<= 1;
+    }
+    quint32 max_targets = (quint32)qMax(1, maxTargets);
+    size_t size = shmSegmentSize(max_targets, ring_size);
+
+    // a name that is taken belongs to another engine, or to one that crashed, and fails with EEXIST
+    QByteArray path = name.toLocal8Bit();
+    int fd = shm_open(path.constData(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) < 0 || ftruncate(fd, size) < 0) {
+        int error = errno;
+        ::close(fd);
+        shm_unlink(path.constData());
+        errno = error;
+        return false;
+    }
+    void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int error = errno;
+    ::close(fd);
+    if(address == MAP_FAILED) {
+        shm_unlink(path.constData());
+        errno = error;
+        return false;
+    }
+
+    // the segment comes zeroed, the magic goes in last so readers never see a partial header
+    ShmHeader* header = new (address) ShmHeader;
+    header->version = ShmVersion;
+    header->max_targets = max_targets;
+    header->ring_size = ring_size;
+    header->sequence.store(0, std::memory_order_relaxed);
+    header->head.store(0, std::memory_order_relaxed);
+    header->dropped.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = ShmMagic;
+
+    impl->name = name;
+    impl->header = header;
+    impl->size = size;
+    impl->device = st.st_dev;
+    impl->inode = st.st_ino;
+    return true;
+}
+
+void ShmStatsWriter::close()
+{
+    if(impl->header) {
+        munmap(impl->header, impl->size);
+
+        // the name may have been taken over since, e.g. after it was removed by hand
+        QByteArray path = impl->name.toLocal8Bit();
+        int fd = shm_open(path.constData(), O_RDONLY | O_CLOEXEC, 0);
+        if(fd >= 0) {
+            struct stat st;
+            if(fstat(fd, &st) == 0 && st.st_dev == impl->device && st.st_ino == impl->inode) {
+                shm_unlink(path.constData());
+            }
+            ::close(fd);
+        }
+        impl->header = nullptr;
+        impl->size = 0;
+        impl->name.clear();
+    }
+}
+
+bool ShmStatsWriter::isOpen() const
+{
+    return impl->header != nullptr;
+}
+
+QString ShmStatsWriter::name() const
+{
+    return impl->name;
+}
+
+void ShmStatsWriter::reset(const QStringList& addresses)
+{
+    ShmHeader* header = impl->header;
+    if(!header) {
+        return;
+    }
+
+    beginUpdate();
+    ++header->run;
+    header->num_targets = (quint32)addresses.size();
+    memset(&header->aggregate, 0, sizeof(header->aggregate));
+    ShmTargetStats* targets = shmTargets(header);
+    for(int i = 0; i < addresses.size() && i < (int)header->max_targets; ++i) {
+        memset(&targets[i], 0, sizeof(targets[i]));
+        strncpy(targets[i].address, addresses[i].toLocal8Bit().constData(), ShmAddressLength - 1);
+    }
+    endUpdate(true);
+}
+
+void ShmStatsWriter::beginUpdate()
+{
+    // the release fence keeps the writes of the snapshot behind the odd sequence
+    ShmHeader* header = impl->header;
+    header->sequence.store(header->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+ShmStats& ShmStatsWriter::aggregate()
+{
+    return impl->header->aggregate;
+}
+
+ShmStats* ShmStatsWriter::target(const int& index)
+{
+    ShmHeader* header = impl->header;
+    return index < (int)header->max_targets ? &shmTargets(header)[index].stats : nullptr;
+}
+
+void ShmStatsWriter::endUpdate(const bool& started)
+{
+    ShmHeader* header = impl->header;
+    header->update_time = QDateTime::currentMSecsSinceEpoch() * 1000;
+    header->started = started ? 1 : 0;
+    header->sequence.store(header->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void ShmStatsWriter::push(const PingSample& sample)
+{
+    ShmHeader* header = impl->header;
+    if(!header) {
+        return;
+    }
+
+    quint64 head = header->head.load(std::memory_order_relaxed);
+    quint64 tail = header->tail.load(std::memory_order_acquire);
+    if(head - tail >= header->ring_size) {
+        header->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ShmSample& slot = shmRing(header)[head & (header->ring_size - 1)];
+    slot.time = sample.time;
+    slot.rtt = sample.rtt;
+    slot.target = sample.target;
+    slot.sequence = sample.sequence;
+    slot.flags = sample.flags;
+    slot.ttl = sample.ttl;
+    slot.bytes = sample.bytes;
+    slot.reserved = 0;
+    slot.forward = sample.forward;
+    slot.reverse = sample.reverse;
+    header->head.store(head + 1, std::memory_order_release);
+}
+
+}
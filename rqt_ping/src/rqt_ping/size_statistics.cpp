@@ -0,0 +1,116 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/size_statistics.h"
+
+namespace rqt_ping {
+
+SizeStatistics::SizeStatistics()
+{
+    min_size = 0;
+    step = 1;
+    largest_reply = 0;
+    reported_mtu = 0;
+}
+
+void SizeStatistics::setRange(const int& minSize, const int& maxSize, const int& step)
+{
+    min_size = minSize;
+    this->step = qMax(1, step);
+    int num_sizes = maxSize >= minSize ? (maxSize - minSize) / this->step + 1 : 0;
+    min_rtts.resize(num_sizes);
+    counts.resize(num_sizes);
+    clear();
+}
+
+void SizeStatistics::clear()
+{
+    min_rtts.fill(0.0);
+    counts.fill(0);
+    largest_reply = 0;
+    reported_mtu = 0;
+}
+
+void SizeStatistics::add(const int& size, const double& rtt)
+{
+    int index = (size - min_size + step / 2) / step;
+    if(size < min_size || index >= numSizes()) {
+        return;
+    }
+    if(counts[index] == 0 || rtt < min_rtts[index]) {
+        min_rtts[index] = rtt;
+    }
+    ++counts[index];
+    largest_reply = qMax(largest_reply, size);
+}
+
+void SizeStatistics::setMtu(const int& mtu)
+{
+    if(mtu > 0 && (reported_mtu == 0 || mtu < reported_mtu)) {
+        reported_mtu = mtu;
+    }
+}
+
+int SizeStatistics::pathMtu() const
+{
+    return reported_mtu > 0 ? reported_mtu : largest_reply;
+}
+
+double SizeStatistics::slope() const
+{
+    double slope, intercept;
+    fit(slope, intercept);
+    return slope;
+}
+
+double SizeStatistics::intercept() const
+{
+    double slope, intercept;
+    fit(slope, intercept);
+    return intercept;
+}
+
+double SizeStatistics::bottleneckRate() const
+{
+    // 8 bits per byte over half the slope in ms gives kbit/s
+    double s = slope();
+    return s > 0.0 ? 16.0 / s / 1000.0 : 0.0;
+}
+
+void SizeStatistics::fit(double& slope, double& intercept) const
+{
+    slope = 0.0;
+    intercept = 0.0;
+
+    int n = 0;
+    double sx = 0.0, sy = 0.0;
+    for(int i = 0; i < numSizes(); ++i) {
+        if(counts[i] > 0) {
+            sx += size(i);
+            sy += min_rtts[i];
+            ++n;
+        }
+    }
+    if(n < 2) {
+        return;
+    }
+
+    // centered sums keep the precision with sizes in the thousands
+    double mx = sx / n;
+    double my = sy / n;
+    double sxx = 0.0, sxy = 0.0;
+    for(int i = 0; i < numSizes(); ++i) {
+        if(counts[i] > 0) {
+            double dx = size(i) - mx;
+            sxx += dx * dx;
+            sxy += dx * (min_rtts[i] - my);
+        }
+    }
+    if(sxx > 0.0) {
+        slope = sxy / sxx;
+        intercept = my - slope * mx;
+    }
+}
+
+}
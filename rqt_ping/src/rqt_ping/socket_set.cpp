@@ -0,0 +1,123 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/socket_set.h"
+
+#include <QHash>
+#include <QSocketNotifier>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace {
+
+const int MaxEvents = 64;
+
+}
+
+namespace rqt_ping {
+
+class SocketSet::Impl
+{
+public:
+    Impl();
+    ~Impl();
+
+    void dispatch();
+
+    QHash<int, Callback> callbacks;
+    QSocketNotifier* notifier;
+    int epfd;
+};
+
+
+SocketSet::SocketSet()
+{
+    impl = new Impl;
+}
+
+SocketSet::Impl::Impl()
+{
+    // a single epoll descriptor stands for every probe socket,
+    // so the Qt event loop watches one fd regardless of the number of targets
+    notifier = nullptr;
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if(epfd >= 0) {
+        notifier = new QSocketNotifier(epfd, QSocketNotifier::Read);
+        QObject::connect(notifier, &QSocketNotifier::activated, [&](){ dispatch(); });
+    }
+}
+
+SocketSet::~SocketSet()
+{
+    delete impl;
+}
+
+SocketSet::Impl::~Impl()
+{
+    delete notifier;
+    if(epfd >= 0) {
+        ::close(epfd);
+    }
+}
+
+bool SocketSet::add(const int& fd, const Callback& callback, const quint32& events)
+{
+    struct epoll_event event;
+    event.events = events;
+    event.data.fd = fd;
+    if(epoll_ctl(impl->epfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        return false;
+    }
+    impl->callbacks.insert(fd, callback);
+    return true;
+}
+
+bool SocketSet::modify(const int& fd, const quint32& events)
+{
+    struct epoll_event event;
+    event.events = events;
+    event.data.fd = fd;
+    return epoll_ctl(impl->epfd, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void SocketSet::remove(const int& fd)
+{
+    if(impl->callbacks.contains(fd)) {
+        epoll_ctl(impl->epfd, EPOLL_CTL_DEL, fd, nullptr);
+        impl->callbacks.remove(fd);
+    }
+}
+
+void SocketSet::clear()
+{
+    QList<int> fds = impl->callbacks.keys();
+    for(int i = 0; i < fds.size(); ++i) {
+        remove(fds.at(i));
+    }
+}
+
+int SocketSet::size() const
+{
+    return impl->callbacks.size();
+}
+
+void SocketSet::Impl::dispatch()
+{
+    struct epoll_event events[MaxEvents];
+    int n = MaxEvents;
+    while(n == MaxEvents) {
+        n = epoll_wait(epfd, events, MaxEvents, 0);
+        for(int i = 0; i < n; ++i) {
+            // a callback may remove other sockets, so look each one up again
+            int fd = events[i].data.fd;
+            if(callbacks.contains(fd)) {
+                Callback callback = callbacks.value(fd);
+                callback(fd, events[i].events);
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,103 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include "rqt_ping/timer_wheel.h"
+
+namespace rqt_ping {
+
+TimerWheel::TimerWheel(const int& numSlots, const qint64& resolution)
+    : spokes(numSlots),
+      resolution_(resolution)
+{
+    clear();
+}
+
+void TimerWheel::clear(const qint64& now)
+{
+    for(size_t i = 0; i < spokes.size(); ++i) {
+        spokes[i].clear();
+    }
+    current = now / resolution_;
+    size_ = 0;
+}
+
+void TimerWheel::setResolution(const qint64& resolution)
+{
+    clear();
+    resolution_ = resolution > 0 ? resolution : 1;
+}
+
+void TimerWheel::schedule(const int& id, const qint64& when)
+{
+    qint64 tick = when / resolution_;
+    if(tick < current) {
+        tick = current;
+    }
+    Entry entry = { id, when, tick };
+    spokes[tick % (qint64)spokes.size()].push_back(entry);
+    ++size_;
+}
+
+int TimerWheel::expire(const qint64& now, std::vector<int>& ids)
+{
+    ids.clear();
+    if(size_ == 0) {
+        return 0;
+    }
+
+    qint64 last = now / resolution_;
+    qint64 numSlots = (qint64)spokes.size();
+    // after a long stall every slot is visited once instead of every elapsed tick
+    qint64 first = last - current >= numSlots ? last - numSlots + 1 : current;
+    for(qint64 tick = first; tick <= last; ++tick) {
+        std::vector<Entry>& slot = spokes[tick % numSlots];
+        size_t j = 0;
+        for(size_t i = 0; i < slot.size(); ++i) {
+            if(slot[i].when <= now) {
+                ids.push_back(slot[i].id);
+            } else {
+                slot[j++] = slot[i];
+            }
+        }
+        slot.resize(j);
+    }
+    current = last;
+    size_ -= (int)ids.size();
+    return (int)ids.size();
+}
+
+qint64 TimerWheel::nextExpiry() const
+{
+    if(size_ == 0) {
+        return -1;
+    }
+
+    qint64 numSlots = (qint64)spokes.size();
+    for(qint64 tick = current; tick < current + numSlots; ++tick) {
+        const std::vector<Entry>& slot = spokes[tick % numSlots];
+        qint64 next = -1;
+        for(size_t i = 0; i < slot.size(); ++i) {
+            if(slot[i].tick == tick && (next < 0 || slot[i].when < next)) {
+                next = slot[i].when;
+            }
+        }
+        if(next >= 0) {
+            return next;
+        }
+    }
+
+    // every entry is more than one revolution away
+    qint64 next = -1;
+    for(qint64 i = 0; i < numSlots; ++i) {
+        const std::vector<Entry>& slot = spokes[i];
+        for(size_t j = 0; j < slot.size(); ++j) {
+            if(next < 0 || slot[j].when < next) {
+                next = slot[j].when;
+            }
+        }
+    }
+    return next;
+}
+
+}
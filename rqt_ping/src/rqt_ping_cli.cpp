@@ -0,0 +1,272 @@
+/**
+   @author Kenta Suzuki
+*/
+
+// headless ping on the probe engine of rqt_ping, streaming CSV or JSON lines to stdout
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <stdio.h>
+
+#include "rqt_ping/ping.h"
+
+using namespace rqt_ping;
+
+namespace {
+
+const int CheckInterval = 50;
+const int OutputBufferSize = 1 << 20;
+
+enum Format { Csv, Json };
+
+struct ModeInfo {
+    const char* name;
+    Ping::Mode mode;
+};
+
+ModeInfo modeInfo[] = {
+    { "icmp", Ping::Icmp }, { "tcp", Ping::TcpConnect }, { "udp", Ping::UdpEcho }, { "twamp", Ping::Twamp }
+};
+
+// host names and addresses only need the quotes and backslashes escaped
+QByteArray jsonString(const QString& text)
+{
+    QByteArray escaped = text.toUtf8();
+    escaped.replace('\\', "\\\\");
+    escaped.replace('"', "\\\"");
+    return escaped;
+}
+
+void printSample(const Format& format, const PingSample& sample, const QVector<QByteArray>& addresses)
+{
+    const char* address = addresses[sample.target].constData();
+    if(format == Csv) {
+        printf("%lld,%s,%d,%u,%.3f,%d,%u,%u\n", (long long)sample.time, address, sample.target,
+            sample.sequence, sample.rtt, sample.ttl, sample.bytes, sample.flags);
+    } else {
+        printf("{\"type\":\"sample\",\"time\":%lld,\"address\":\"%s\",\"target\":%d,\"sequence\":%u,"
+            "\"rtt\":%.3f,\"ttl\":%d,\"bytes\":%u,\"flags\":%u", (long long)sample.time, address, sample.target,
+            sample.sequence, sample.rtt, sample.ttl, sample.bytes, sample.flags);
+        if(sample.flags & PingSample::OneWay) {
+            printf(",\"forward\":%.3f,\"reverse\":%.3f", sample.forward, sample.reverse);
+        }
+        printf("}\n");
+    }
+}
+
+void printSummary(FILE* file, const Format& format, const char* address, const int& transmitted,
+    const int& received, const int& lost, const double& loss, const RttStatistics& statistics,
+    const int& duplicates, const int& reordered, const int& late, const double& jitter)
+{
+    if(format == Csv) {
+        fprintf(file, "%s,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d,%d,%.3f\n", address,
+            transmitted, received, lost, loss, statistics.min(), statistics.avg(), statistics.max(),
+            statistics.mdev(), statistics.percentile(50.0), statistics.percentile(90.0),
+            statistics.percentile(99.0), statistics.percentile(99.9), duplicates, reordered, late, jitter);
+    } else {
+        fprintf(file, "{\"type\":\"summary\",\"address\":\"%s\",\"transmitted\":%d,\"received\":%d,\"lost\":%d,"
+            "\"loss\":%.3f,\"min\":%.3f,\"avg\":%.3f,\"max\":%.3f,\"mdev\":%.3f,\"p50\":%.3f,\"p90\":%.3f,"
+            "\"p99\":%.3f,\"p999\":%.3f,\"duplicates\":%d,\"reordered\":%d,\"late\":%d,\"jitter\":%.3f}\n",
+            address, transmitted, received, lost, loss, statistics.min(), statistics.avg(), statistics.max(),
+            statistics.mdev(), statistics.percentile(50.0), statistics.percentile(90.0),
+            statistics.percentile(99.0), statistics.percentile(99.9), duplicates, reordered, late, jitter);
+    }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("rqt_ping_cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Ping many targets with the rqt_ping engine and stream the results.\n"
+        "Samples go to stdout, the per-target summary follows them in JSON and goes to stderr in CSV.\n"
+        "The exit status is 2 when a target exceeds --max-loss or --max-p99.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("addresses", "Hosts, addresses or CIDR ranges.", "addresses...");
+    QCommandLineOption countOption(QStringList() << "c" << "count", "Stop after <count> probes per target.", "count", "0");
+    QCommandLineOption waitOption(QStringList() << "i" << "interval", "Seconds between probes.", "second", "1.0");
+    QCommandLineOption timeoutOption(QStringList() << "W" << "timeout", "Seconds until a probe is lost.", "second", "2.0");
+    QCommandLineOption deadlineOption(QStringList() << "w" << "deadline", "Stop after <second> seconds.", "second", "0");
+    QCommandLineOption modeOption(QStringList() << "m" << "mode", "icmp, tcp, udp or twamp.", "mode", "icmp");
+    QCommandLineOption ipv4Option("4", "Probe over IPv4 only.");
+    QCommandLineOption ipv6Option("6", "Probe over IPv6 only.");
+    QCommandLineOption dualStackOption("dual-stack", "Probe every name over both IPv4 and IPv6.");
+    QCommandLineOption hopsOption("hops", "Probe every hop up to TTL <hops>, mtr-style (icmp).", "hops", "0");
+    QCommandLineOption portOption(QStringList() << "p" << "port", "Port of the tcp, udp and twamp modes.", "port", "0");
+    QCommandLineOption highRateOption("high-rate", "Allow intervals below 0.2 s with kernel timestamps.");
+    QCommandLineOption formatOption(QStringList() << "f" << "format", "csv or json.", "format", "csv");
+    QCommandLineOption summaryOption(QStringList() << "s" << "summary", "Write only the summary, to stdout.");
+    QCommandLineOption shmOption("shm", "Export the statistics to shared memory <name>.", "name");
+    QCommandLineOption recordOption(QStringList() << "r" << "record", "Record the session to <file>.", "file");
+    QCommandLineOption maxLossOption("max-loss", "Fail above <percent> loss on any target.", "percent", "-1");
+    QCommandLineOption maxP99Option("max-p99", "Fail above a p99 rtt of <ms> on any target.", "ms", "-1");
+    parser.addOptions({ countOption, waitOption, timeoutOption, deadlineOption, modeOption,
+        ipv4Option, ipv6Option, dualStackOption, hopsOption, portOption,
+        highRateOption, formatOption, summaryOption, shmOption, recordOption, maxLossOption, maxP99Option });
+    parser.process(app);
+
+    if(parser.positionalArguments().isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    Ping::Mode mode = Ping::Icmp;
+    bool is_valid_mode = false;
+    for(const ModeInfo& info : modeInfo) {
+        if(parser.value(modeOption) == info.name) {
+            mode = info.mode;
+            is_valid_mode = true;
+        }
+    }
+    QString format_name = parser.value(formatOption);
+    if(!is_valid_mode || (format_name != "csv" && format_name != "json")) {
+        parser.showHelp(1);
+    }
+    Format format = format_name == "csv" ? Csv : Json;
+    bool is_summary_only = parser.isSet(summaryOption);
+    int count = parser.value(countOption).toInt();
+    double wait = parser.value(waitOption).toDouble();
+    double timeout = parser.value(timeoutOption).toDouble();
+    double deadline = parser.value(deadlineOption).toDouble();
+    if(count > 0 && deadline <= 0.0) {
+        // the fallback on the ping command only resolves its probes when it stops
+        deadline = count * wait + timeout + 1.0;
+    }
+    double max_loss = parser.value(maxLossOption).toDouble();
+    double max_p99 = parser.value(maxP99Option).toDouble();
+
+    // thousands of targets at high rates write a lot of lines
+    static char buffer[OutputBufferSize];
+    setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+    Ping ping;
+    ping.setAddresses(Ping::expandAddresses(parser.positionalArguments().join(" ")));
+    ping.setCount(count);
+    ping.setWait(wait);
+    ping.setTimeout(timeout);
+    ping.setHighRate(parser.isSet(highRateOption));
+    ping.setMode(mode);
+    ping.setFamily(parser.isSet(dualStackOption) ? Ping::DualStack
+        : (parser.isSet(ipv6Option) ? Ping::Ipv6 : (parser.isSet(ipv4Option) ? Ping::Ipv4 : Ping::AnyFamily)));
+    ping.setPort(parser.value(portOption).toInt());
+    ping.setMaxHops(parser.value(hopsOption).toInt());
+    if(parser.isSet(shmOption)) {
+        ping.setSharedMemory(parser.value(shmOption));
+    }
+    if(parser.isSet(recordOption)) {
+        ping.setRecordFile(parser.value(recordOption));
+    }
+
+    // the log of the engine goes to stderr, so stdout stays machine readable
+    QObject::connect(&ping, &Ping::output, [&](QString text){
+        fprintf(stderr, "%s\n", text.toLocal8Bit().constData());
+    });
+
+    QVector<QByteArray> addresses;
+    if(!is_summary_only) {
+        QObject::connect(&ping, &Ping::sampled, [&](PingSample sample){
+            printSample(format, sample, addresses);
+        });
+    }
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    ping.start();
+    if(ping.numTargets() == 0) {
+        return 1;
+    }
+    for(int i = 0; i < ping.numTargets(); ++i) {
+        addresses << (format == Json ? jsonString(ping.address(i)) : ping.address(i).toUtf8());
+    }
+    if(format == Csv && !is_summary_only) {
+        printf("time,address,target,sequence,rtt,ttl,bytes,flags\n");
+    }
+
+    // with a count, the run ends once every probe is either answered or lost
+    QTimer checkTimer;
+    QObject::connect(&checkTimer, &QTimer::timeout, [&](){
+        if(deadline > 0.0 && elapsed.elapsed() >= (qint64)(deadline * 1000.0)) {
+            app.quit();
+        }
+        // hops behind the destination are no longer probed
+        qint64 expected = 0;
+        for(int i = 0; count > 0 && i < ping.numTargets(); ++i) {
+            expected += ping.beyondDestination(i) ? ping.transmittedPackets(i) : count;
+        }
+        if(count > 0 && ping.transmittedPackets() >= expected
+                && ping.receivedPackets() + ping.lostPackets() >= ping.transmittedPackets()) {
+            app.quit();
+        }
+        fflush(stdout);
+    });
+    checkTimer.start(CheckInterval);
+    app.exec();
+    ping.stop();
+    double second = (double)elapsed.elapsed() / 1000.0;
+
+    FILE* file = is_summary_only || format == Json ? stdout : stderr;
+    if(format == Csv) {
+        fprintf(file, "address,transmitted,received,lost,loss,min,avg,max,mdev,p50,p90,p99,p999,"
+            "duplicates,reordered,late,jitter\n");
+    }
+    int status = 0;
+    int duplicates = 0, reordered = 0, late = 0;
+    for(int i = 0; i < ping.numTargets(); ++i) {
+        if(ping.beyondDestination(i)) {
+            continue;
+        }
+        // a hop is named after the router that answered it
+        QByteArray address = addresses[i];
+        if(ping.hop(i) > 0 && !ping.responder(i).isEmpty()) {
+            address += " ";
+            address += ping.responder(i).toUtf8();
+        }
+        const RttStatistics& statistics = ping.statistics(i);
+        printSummary(file, format, address.constData(), ping.transmittedPackets(i), ping.receivedPackets(i),
+            ping.lostPackets(i), ping.loss(i), statistics, ping.duplicatePackets(i), ping.reorderedPackets(i),
+            ping.latePackets(i), ping.jitter(i));
+        duplicates += ping.duplicatePackets(i);
+        reordered += ping.reorderedPackets(i);
+        late += ping.latePackets(i);
+
+        if((max_loss >= 0.0 && ping.loss(i) > max_loss)
+                || (max_p99 >= 0.0 && (statistics.count() == 0 || statistics.percentile(99.0) > max_p99))) {
+            status = 2;
+        }
+    }
+    if(ping.family() == Ping::DualStack) {
+        // the same impairments seen over either family
+        for(Ping::Family family : { Ping::Ipv4, Ping::Ipv6 }) {
+            int transmitted = 0, received = 0, lost = 0;
+            int family_duplicates = 0, family_reordered = 0, family_late = 0;
+            for(int i = 0; i < ping.numTargets(); ++i) {
+                if(ping.targetFamily(i) == family) {
+                    transmitted += ping.transmittedPackets(i);
+                    received += ping.receivedPackets(i);
+                    lost += ping.lostPackets(i);
+                    family_duplicates += ping.duplicatePackets(i);
+                    family_reordered += ping.reorderedPackets(i);
+                    family_late += ping.latePackets(i);
+                }
+            }
+            double loss = transmitted > 0 ? (double)lost / (double)transmitted * 100.0 : 0.0;
+            printSummary(file, format, family == Ping::Ipv4 ? "ipv4" : "ipv6", transmitted, received, lost, loss,
+                ping.familyStatistics(family), family_duplicates, family_reordered, family_late, 0.0);
+        }
+    }
+    printSummary(file, format, "total", ping.transmittedPackets(), ping.receivedPackets(), ping.lostPackets(),
+        ping.loss(), ping.statistics(), duplicates, reordered, late, 0.0);
+
+    // probe and reply rates make runs of the engine comparable
+    fprintf(stderr, "%d targets, %d probes, %d replies in %.3f s: %.0f probes/s, %.0f replies/s\n",
+        ping.numTargets(), ping.transmittedPackets(), ping.receivedPackets(), second,
+        second > 0.0 ? ping.transmittedPackets() / second : 0.0, second > 0.0 ? ping.receivedPackets() / second : 0.0);
+    fflush(stdout);
+    return status;
+}
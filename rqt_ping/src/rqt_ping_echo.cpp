@@ -0,0 +1,99 @@
+/**
+   @author Kenta Suzuki
+*/
+
+// UDP echo reflector (RFC 862) for the UDP probe mode of rqt_ping
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// the well-known echo port 7 needs root to be bound
+const int DefaultPort = 10007;
+const int BatchSize = 64;
+const int BufferSize = 9216;
+
+}
+
+int main(int argc, char** argv)
+{
+    int port = argc > 1 ? atoi(argv[1]) : DefaultPort;
+    if(port <= 0 || port > 65535) {
+        fprintf(stderr, "usage: %s [port=%d], 7 is the well-known echo port\n", argv[0], DefaultPort);
+        return 1;
+    }
+
+    // one dual-stack socket answers the IPv4 probes as mapped addresses as well
+    int fd = socket(AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+    if(fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    int size = 4 * 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    int off = 0;
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+
+    struct sockaddr_in6 addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons((unsigned short)port);
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        return 1;
+    }
+
+    static char buffers[BatchSize][BufferSize];
+    struct sockaddr_in6 peers[BatchSize];
+    struct iovec iovs[BatchSize];
+    struct mmsghdr msgs[BatchSize];
+
+    // replies go back in the same batches they arrived in
+    while(true) {
+        memset(msgs, 0, sizeof(msgs));
+        for(int i = 0; i < BatchSize; ++i) {
+            iovs[i].iov_base = buffers[i];
+            iovs[i].iov_len = BufferSize;
+            msgs[i].msg_hdr.msg_name = &peers[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(peers[i]);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int n = recvmmsg(fd, msgs, BatchSize, MSG_WAITFORONE, nullptr);
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            perror("recvmmsg");
+            break;
+        }
+        for(int i = 0; i < n; ++i) {
+            iovs[i].iov_len = msgs[i].msg_len;
+        }
+        for(int sent = 0; sent < n; ) {
+            int ret = sendmmsg(fd, msgs + sent, n - sent, 0);
+            if(ret < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                // drop the datagram that failed and carry on with the rest
+                ++sent;
+                continue;
+            }
+            sent += ret;
+        }
+    }
+
+    close(fd);
+    return 0;
+}
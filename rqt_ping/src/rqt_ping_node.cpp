@@ -0,0 +1,194 @@
+/**
+   @author Kenta Suzuki
+*/
+
+#include <QCoreApplication>
+#include <QTimer>
+
+#include <ros/ros.h>
+#include <std_msgs/Float64MultiArray.h>
+#include <std_msgs/MultiArrayDimension.h>
+
+#include <vector>
+
+#include "rqt_ping/ping.h"
+
+using namespace rqt_ping;
+
+namespace {
+
+enum { Time, Target, Sequence, Rtt, Ttl, NumSampleFields };
+enum {
+    Transmitted, Received, Loss, Min, Avg, Max, Mdev,
+    P50, P90, P99, P999, Lost, Duplicates, Reordered, Late, NumStatisticsFields
+};
+
+void setLayout(std_msgs::Float64MultiArray& msg, const char* rows, const int& numRows,
+    const char* columns, const int& numColumns)
+{
+    msg.layout.dim.resize(2);
+    msg.layout.dim[0].label = rows;
+    msg.layout.dim[0].size = numRows;
+    msg.layout.dim[0].stride = numRows * numColumns;
+    msg.layout.dim[1].label = columns;
+    msg.layout.dim[1].size = numColumns;
+    msg.layout.dim[1].stride = numColumns;
+    msg.layout.data_offset = 0;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    ros::init(argc, argv, "rqt_ping_node");
+    QCoreApplication app(argc, argv);
+
+    ros::NodeHandle nh("~");
+    std::string addresses;
+    int count;
+    double wait;
+    double timeout;
+    bool high_rate;
+    std::string mode;
+    int port;
+    int sweep_min;
+    int sweep_max;
+    int sweep_step;
+    int max_hops;
+    std::string family;
+    std::string load;
+    int flows;
+    double idle_time;
+    double load_rate;
+    int load_port;
+    std::string shm_name;
+    std::string record_file;
+    double sample_rate;
+    double statistics_rate;
+    nh.param<std::string>("addresses", addresses, "127.0.0.1");
+    nh.param("count", count, 0);
+    nh.param("wait", wait, 1.0);
+    nh.param("timeout", timeout, 2.0);
+    nh.param("high_rate", high_rate, false);
+    nh.param<std::string>("mode", mode, "icmp");
+    nh.param<std::string>("family", family, "any");
+    nh.param("port", port, 0);
+    nh.param("sweep_min", sweep_min, 84);
+    nh.param("sweep_max", sweep_max, 0);
+    nh.param("sweep_step", sweep_step, 64);
+    nh.param("max_hops", max_hops, 0);
+    nh.param<std::string>("load", load, "none");
+    nh.param("flows", flows, 1);
+    nh.param("idle_time", idle_time, 5.0);
+    nh.param("load_rate", load_rate, 100.0);
+    nh.param("load_port", load_port, 0);
+    nh.param<std::string>("shm_name", shm_name, "");
+    nh.param<std::string>("record_file", record_file, "");
+    nh.param("sample_rate", sample_rate, 10.0);
+    nh.param("statistics_rate", statistics_rate, 1.0);
+
+    // samples: one row per reply, columns are time [s since the epoch], target, icmp_seq, rtt [ms], ttl
+    // statistics: one row per target, columns are transmitted, received, loss [%], min, avg, max, mdev,
+    // p50, p90, p99, p99.9 [ms], lost, duplicates, reordered, late,
+    // with max_hops each address takes that many rows, one per hop
+    ros::Publisher samplePub = nh.advertise<std_msgs::Float64MultiArray>("samples", 10);
+    ros::Publisher statisticsPub = nh.advertise<std_msgs::Float64MultiArray>("statistics", 10, true);
+
+    Ping ping;
+    std::vector<PingSample> samples;
+    QObject::connect(&ping, &Ping::output, [&](QString text){ ROS_INFO("%s", text.toLocal8Bit().constData()); });
+    QObject::connect(&ping, &Ping::sampled, [&](PingSample sample){ samples.push_back(sample); });
+
+    // replies are batched and published at a fixed rate, whatever the probe rate is
+    QTimer sampleTimer;
+    QObject::connect(&sampleTimer, &QTimer::timeout, [&](){
+        if(samples.empty()) {
+            return;
+        }
+        std_msgs::Float64MultiArray msg;
+        setLayout(msg, "sample", (int)samples.size(), "time,target,sequence,rtt,ttl", NumSampleFields);
+        msg.data.resize(samples.size() * NumSampleFields);
+        for(size_t i = 0; i < samples.size(); ++i) {
+            const PingSample& sample = samples[i];
+            double* row = &msg.data[i * NumSampleFields];
+            row[Time] = (double)sample.time / 1000000.0;
+            row[Target] = sample.target;
+            row[Sequence] = sample.sequence;
+            row[Rtt] = sample.rtt;
+            row[Ttl] = sample.ttl;
+        }
+        samplePub.publish(msg);
+        samples.clear();
+    });
+
+    QTimer statisticsTimer;
+    QObject::connect(&statisticsTimer, &QTimer::timeout, [&](){
+        int numTargets = ping.numTargets();
+        std_msgs::Float64MultiArray msg;
+        setLayout(msg, "target", numTargets,
+            "transmitted,received,loss,min,avg,max,mdev,p50,p90,p99,p999,lost,duplicates,reordered,late",
+            NumStatisticsFields);
+        msg.data.resize(numTargets * NumStatisticsFields);
+        for(int i = 0; i < numTargets; ++i) {
+            const RttStatistics& statistics = ping.statistics(i);
+            double* row = &msg.data[i * NumStatisticsFields];
+            row[Transmitted] = ping.transmittedPackets(i);
+            row[Received] = ping.receivedPackets(i);
+            row[Loss] = ping.loss(i);
+            row[Min] = statistics.min();
+            row[Avg] = statistics.avg();
+            row[Max] = statistics.max();
+            row[Mdev] = statistics.mdev();
+            row[P50] = statistics.percentile(50.0);
+            row[P90] = statistics.percentile(90.0);
+            row[P99] = statistics.percentile(99.0);
+            row[P999] = statistics.percentile(99.9);
+            row[Lost] = ping.lostPackets(i);
+            row[Duplicates] = ping.duplicatePackets(i);
+            row[Reordered] = ping.reorderedPackets(i);
+            row[Late] = ping.latePackets(i);
+        }
+        statisticsPub.publish(msg);
+    });
+
+    // ROS callbacks are serviced from the Qt event loop that drives the probe engine
+    QTimer spinTimer;
+    QObject::connect(&spinTimer, &QTimer::timeout, [&](){
+        ros::spinOnce();
+        if(!ros::ok()) {
+            app.quit();
+        }
+    });
+
+    ping.setAddresses(Ping::expandAddresses(QString::fromStdString(addresses)));
+    ping.setCount(count);
+    ping.setWait(wait);
+    ping.setTimeout(timeout);
+    ping.setHighRate(high_rate);
+    ping.setMode(mode == "tcp" ? Ping::TcpConnect : (mode == "udp" ? Ping::UdpEcho
+        : (mode == "twamp" ? Ping::Twamp : Ping::Icmp)));
+    ping.setFamily(family == "ipv4" ? Ping::Ipv4 : (family == "ipv6" ? Ping::Ipv6
+        : (family == "dual" ? Ping::DualStack : Ping::AnyFamily)));
+    ping.setPort(port);
+    ping.setSizeSweep(sweep_min, sweep_max, sweep_step);
+    ping.setMaxHops(max_hops);
+    ping.setSharedMemory(QString::fromStdString(shm_name));
+    ping.setRecordFile(QString::fromStdString(record_file));
+    ping.setLoad(load == "tcp" ? Ping::TcpLoad : (load == "udp" ? Ping::UdpLoad : Ping::NoLoad), flows);
+    ping.setIdleTime(idle_time);
+    ping.setLoadRate(load_rate);
+    ping.setLoadPort(load_port);
+    ping.start();
+    if(ping.numTargets() == 0) {
+        ROS_ERROR("no target could be resolved from '%s'", addresses.c_str());
+        return 1;
+    }
+
+    sampleTimer.start(qMax(1, (int)(1000.0 / sample_rate)));
+    statisticsTimer.start(qMax(1, (int)(1000.0 / statistics_rate)));
+    spinTimer.start(10);
+
+    int ret = app.exec();
+    ping.stop();
+    return ret;
+}
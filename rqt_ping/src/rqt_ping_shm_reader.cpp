@@ -0,0 +1,67 @@
+/**
+   @author Kenta Suzuki
+*/
+
+// prints the live statistics that rqt_ping exports to shared memory, and drains the samples
+// when it may write to the segment
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "rqt_ping/shm_stats.h"
+
+using namespace rqt_ping;
+
+namespace {
+
+const int MaxSamples = 1024;
+
+void print(const char* name, const ShmStats& stats)
+{
+    printf("%s: %llu/%llu received, %.1f%% loss, rtt min/avg/max/p99 = %.3f/%.3f/%.3f/%.3f ms\n", name,
+        (unsigned long long)stats.received, (unsigned long long)stats.transmitted, stats.loss,
+        stats.min, stats.avg, stats.max, stats.p99);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const char* name = argc > 1 ? argv[1] : "/rqt_ping";
+    double interval = argc > 2 ? atof(argv[2]) : 1.0;
+
+    // the samples are only drained by the user of the engine, everyone else gets the statistics
+    ShmStatsReader reader;
+    if(!reader.open(name, ShmStatsReader::Consumer) && !reader.open(name)) {
+        fprintf(stderr, "usage: %s [name=/rqt_ping] [interval=1.0]\n%s: no rqt_ping segment\n", argv[0], name);
+        return 1;
+    }
+    if(!reader.isConsumer()) {
+        fprintf(stderr, "%s: opened read-only, the samples are not drained\n", name);
+    }
+
+    static ShmSample samples[MaxSamples];
+    ShmSnapshot snapshot;
+    while(true) {
+        // the samples are only counted here, a recorder would write them out
+        unsigned long long received = 0;
+        int n;
+        while((n = reader.readSamples(samples, MaxSamples)) > 0) {
+            received += n;
+        }
+
+        if(reader.snapshot(snapshot)) {
+            printf("--- run %llu, %u targets, %s, %llu samples (%llu dropped) ---\n",
+                (unsigned long long)snapshot.run, snapshot.num_targets, snapshot.started ? "running" : "stopped",
+                received, (unsigned long long)reader.droppedSamples());
+            print("total", snapshot.aggregate);
+            for(size_t i = 0; i < snapshot.targets.size(); ++i) {
+                print(snapshot.targets[i].address, snapshot.targets[i].stats);
+            }
+            fflush(stdout);
+        }
+        usleep((useconds_t)(interval * 1000000.0));
+    }
+    return 0;
+}
@@ -0,0 +1,171 @@
+/**
+   @author Kenta Suzuki
+*/
+
+// TCP and UDP discard sink (RFC 863) for the load flows of rqt_ping
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+
+namespace {
+
+// the well-known discard port 9 needs root to be bound
+const int DefaultPort = 10009;
+const int MaxEvents = 64;
+const int BufferSize = 262144;
+
+struct Connection {
+    std::string peer;
+    unsigned long long bytes;
+    double start;
+};
+
+double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+std::string peerName(const struct sockaddr_in6& addr)
+{
+    // IPv4 peers show up as mapped addresses on the dual-stack sockets
+    char host[INET6_ADDRSTRLEN];
+    if(IN6_IS_ADDR_V4MAPPED(&addr.sin6_addr)) {
+        inet_ntop(AF_INET, &addr.sin6_addr.s6_addr[12], host, sizeof(host));
+        return std::string(host) + ":" + std::to_string(ntohs(addr.sin6_port));
+    }
+    inet_ntop(AF_INET6, &addr.sin6_addr, host, sizeof(host));
+    return "[" + std::string(host) + "]:" + std::to_string(ntohs(addr.sin6_port));
+}
+
+void report(const Connection& connection, const char* protocol)
+{
+    double elapsed = now() - connection.start;
+    printf("%s %s: %llu bytes in %.2f s (%.2f Mbit/s)\n", protocol, connection.peer.c_str(), connection.bytes,
+        elapsed, elapsed > 0.0 ? (double)connection.bytes * 8.0 / elapsed / 1000000.0 : 0.0);
+    fflush(stdout);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    int port = argc > 1 ? atoi(argv[1]) : DefaultPort;
+    if(port <= 0 || port > 65535) {
+        fprintf(stderr, "usage: %s [port=%d], 9 is the well-known discard port\n", argv[0], DefaultPort);
+        return 1;
+    }
+
+    struct sockaddr_in6 addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons((unsigned short)port);
+
+    int listener = socket(AF_INET6, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int datagram = socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(listener < 0 || datagram < 0) {
+        perror("socket");
+        return 1;
+    }
+    int on = 1;
+    int off = 0;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(listener, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    setsockopt(datagram, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    int size = 4 * 1024 * 1024;
+    setsockopt(datagram, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    if(bind(listener, (struct sockaddr*)&addr, sizeof(addr)) < 0
+            || bind(datagram, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        return 1;
+    }
+    listen(listener, 64);
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = listener;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listener, &event);
+    event.data.fd = datagram;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, datagram, &event);
+
+    static char buffer[BufferSize];
+    std::map<int, Connection> connections;
+    std::map<std::string, Connection> senders;
+    double last_report = now();
+
+    while(true) {
+        struct epoll_event events[MaxEvents];
+        int n = epoll_wait(epfd, events, MaxEvents, 1000);
+        if(n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+        for(int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if(fd == listener) {
+                struct sockaddr_in6 peer;
+                socklen_t length = sizeof(peer);
+                int connection = accept4(listener, (struct sockaddr*)&peer, &length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if(connection >= 0) {
+                    event.data.fd = connection;
+                    epoll_ctl(epfd, EPOLL_CTL_ADD, connection, &event);
+                    connections[connection] = Connection{ peerName(peer), 0, now() };
+                }
+            } else if(fd == datagram) {
+                // UDP senders are told apart by their address and reported once a second
+                while(true) {
+                    struct sockaddr_in6 peer;
+                    socklen_t length = sizeof(peer);
+                    ssize_t ret = recvfrom(datagram, buffer, sizeof(buffer), 0, (struct sockaddr*)&peer, &length);
+                    if(ret < 0) {
+                        break;
+                    }
+                    std::string name = peerName(peer);
+                    auto it = senders.find(name);
+                    if(it == senders.end()) {
+                        it = senders.insert(std::make_pair(name, Connection{ name, 0, now() })).first;
+                    }
+                    it->second.bytes += ret;
+                }
+            } else {
+                ssize_t ret;
+                while((ret = read(fd, buffer, sizeof(buffer))) > 0) {
+                    connections[fd].bytes += ret;
+                }
+                if(ret == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    report(connections[fd], "tcp");
+                    connections.erase(fd);
+                    epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+                    close(fd);
+                }
+            }
+        }
+
+        if(now() - last_report >= 1.0) {
+            for(auto it = senders.begin(); it != senders.end(); ++it) {
+                report(it->second, "udp");
+            }
+            senders.clear();
+            last_report = now();
+        }
+    }
+
+    close(epfd);
+    close(datagram);
+    close(listener);
+    return 0;
+}
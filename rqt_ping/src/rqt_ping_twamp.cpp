@@ -0,0 +1,142 @@
+/**
+   @author Kenta Suzuki
+*/
+
+// TWAMP-light session reflector (RFC 5357) for the one-way delay mode of rqt_ping
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rqt_ping/twamp_packet.h"
+
+using namespace rqt_ping;
+
+namespace {
+
+const int BufferSize = 2048;
+
+qint64 nanoseconds(const struct timespec& ts)
+{
+    return (qint64)ts.tv_sec * 1000000000LL + (qint64)ts.tv_nsec;
+}
+
+qint64 now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return nanoseconds(ts);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    int port = argc > 1 ? atoi(argv[1]) : DefaultTwampPort;
+    if(port <= 0 || port > 65535) {
+        fprintf(stderr, "usage: %s [port=%d], 862 is the well-known TWAMP port\n", argv[0], DefaultTwampPort);
+        return 1;
+    }
+
+    // one dual-stack socket answers the IPv4 senders as mapped addresses as well
+    int fd = socket(AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+    if(fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    // the receive timestamp is taken by the kernel, the transmit timestamp right before sending
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+    setsockopt(fd, IPPROTO_IP, IP_RECVTTL, &on, sizeof(on));
+    setsockopt(fd, IPPROTO_IPV6, IPV6_RECVHOPLIMIT, &on, sizeof(on));
+    int off = 0;
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+
+    struct sockaddr_in6 addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons((unsigned short)port);
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        return 1;
+    }
+
+    char buffer[BufferSize];
+    char control[256];
+    quint32 sequence = 0;
+
+    while(true) {
+        struct sockaddr_in6 from;
+        struct iovec iov = { buffer, sizeof(buffer) };
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &from;
+        msg.msg_namelen = sizeof(from);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t length = recvmsg(fd, &msg, 0);
+        if(length < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            perror("recvmsg");
+            break;
+        }
+
+        qint64 received = 0;
+        int ttl = 255;
+        for(struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+                received = nanoseconds(*(struct timespec*)CMSG_DATA(cmsg));
+            } else if((cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_TTL)
+                    || (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_HOPLIMIT)) {
+                ttl = *(int*)CMSG_DATA(cmsg);
+            }
+        }
+        if(received == 0) {
+            received = now();
+        }
+        if(length < (ssize_t)sizeof(TwampSenderPacket)) {
+            continue;
+        }
+
+        TwampSenderPacket request;
+        memcpy(&request, buffer, sizeof(request));
+
+        // reply with the same length as the request, padding included
+        int reply_length = qMax((int)length, TwampPacketLength);
+        if(reply_length > BufferSize) {
+            continue;
+        }
+        if(reply_length > (int)length) {
+            memset(buffer + length, 0, reply_length - length);
+        }
+
+        TwampReflectorPacket reply;
+        memset(&reply, 0, sizeof(reply));
+        reply.sequence = htonl(sequence++);
+        reply.error_estimate = htons(TwampErrorEstimate);
+        reply.receive_timestamp = toNtpTimestamp(received);
+        reply.sender_sequence = request.sequence;
+        reply.sender_timestamp = request.timestamp;
+        reply.sender_error_estimate = request.error_estimate;
+        reply.sender_ttl = (quint8)ttl;
+        reply.timestamp = toNtpTimestamp(now());
+        memcpy(buffer, &reply, sizeof(reply));
+
+        sendto(fd, buffer, reply_length, 0, (struct sockaddr*)&from, sizeof(from));
+    }
+
+    close(fd);
+    return 0;
+}